@@ -0,0 +1,272 @@
+#include "AssetPack.h"
+#include "MemoryTracker.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static size_t align16(size_t n) {
+	return (n + 15) & ~(size_t)15;
+}
+
+static ofImageType channelsToType(int channels) {
+	if (channels == 4) return OF_IMAGE_COLOR_ALPHA;
+	if (channels == 3) return OF_IMAGE_COLOR;
+	return OF_IMAGE_GRAYSCALE;
+}
+
+AssetPack::AssetPack() {
+	base = NULL;
+	length = 0;
+	header = NULL;
+	blocks = NULL;
+	entries = NULL;
+	fileHandle = NULL;
+	mapHandle = NULL;
+}
+
+AssetPack::~AssetPack() {
+	close();
+}
+
+//  Decode every named image and write the pack. Images no larger than
+//  PACK_ATLAS_MAX are converted to RGBA and shelf packed, tallest first,
+//  into one atlas PACK_ATLAS_WIDTH wide; the rest are stored as they
+//  decode.
+//
+bool AssetPack::build(const vector<string> &names, const string &path) {
+	int n = names.size();
+	vector<ofPixels> images(n);
+	for (int i = 0; i < n; i++) {
+		if (names[i].size() >= PACK_NAME_LEN) {
+			cout << "asset pack: name too long: " << names[i] << endl;
+			return false;
+		}
+		if (!ofLoadImage(images[i], names[i])) {
+			cout << "asset pack: can't load " << names[i] << endl;
+			return false;
+		}
+	}
+
+	vector<int> small;
+	vector<bool> inAtlas(n, false);
+	for (int i = 0; i < n; i++) {
+		if (images[i].getWidth() <= PACK_ATLAS_MAX && images[i].getHeight() <= PACK_ATLAS_MAX) {
+			small.push_back(i);
+			inAtlas[i] = true;
+		}
+	}
+	std::stable_sort(small.begin(), small.end(), [&](int a, int b) {
+		return images[a].getHeight() > images[b].getHeight();
+	});
+
+	vector<PackBlock> blocks;
+	vector<PackEntry> entries(n);
+	for (int i = 0; i < n; i++) {
+		memset(&entries[i], 0, sizeof(PackEntry));
+		strncpy(entries[i].name, names[i].c_str(), PACK_NAME_LEN - 1);
+		entries[i].width = images[i].getWidth();
+		entries[i].height = images[i].getHeight();
+	}
+
+	// shelf pack the small images
+	//
+	if (!small.empty()) {
+		int x = 0, y = 0, shelf = 0;
+		for (int k = 0; k < small.size(); k++) {
+			PackEntry &e = entries[small[k]];
+			if (x + e.width > PACK_ATLAS_WIDTH) {
+				x = 0;
+				y += shelf;
+				shelf = 0;
+			}
+			e.block = 0;
+			e.x = x;
+			e.y = y;
+			x += e.width;
+			shelf = MAX(shelf, (int)e.height);
+		}
+		PackBlock atlas = { PACK_ATLAS_WIDTH, (uint32_t)(y + shelf), 4, 0, 0 };
+		blocks.push_back(atlas);
+	}
+	for (int i = 0; i < n; i++) {
+		if (inAtlas[i]) continue;
+		entries[i].block = blocks.size();
+		PackBlock b = { entries[i].width, entries[i].height, (uint32_t)images[i].getNumChannels(), 0, 0 };
+		blocks.push_back(b);
+	}
+
+	// lay out the file
+	//
+	size_t offset = align16(sizeof(PackHeader) + blocks.size() * sizeof(PackBlock) + n * sizeof(PackEntry));
+	for (int b = 0; b < blocks.size(); b++) {
+		blocks[b].offset = offset;
+		offset = align16(offset + (size_t)blocks[b].width * blocks[b].height * blocks[b].channels);
+	}
+	vector<char> data(offset, 0);
+
+	PackHeader *h = (PackHeader *)data.data();
+	h->magic = PACK_MAGIC;
+	h->version = PACK_VERSION;
+	h->numBlocks = blocks.size();
+	h->numEntries = n;
+	memcpy(data.data() + sizeof(PackHeader), blocks.data(), blocks.size() * sizeof(PackBlock));
+	memcpy(data.data() + sizeof(PackHeader) + blocks.size() * sizeof(PackBlock), entries.data(), n * sizeof(PackEntry));
+
+	// copy the pixels, converting atlas entries to RGBA
+	//
+	for (int i = 0; i < n; i++) {
+		const PackEntry &e = entries[i];
+		const PackBlock &b = blocks[e.block];
+		const unsigned char *src = images[i].getData();
+		int channels = images[i].getNumChannels();
+		for (int row = 0; row < e.height; row++) {
+			unsigned char *dst = (unsigned char *)data.data() + b.offset + ((size_t)(e.y + row) * b.width + e.x) * b.channels;
+			const unsigned char *s = src + (size_t)row * e.width * channels;
+			if (channels == b.channels) {
+				memcpy(dst, s, e.width * channels);
+				continue;
+			}
+			for (int col = 0; col < e.width; col++, dst += 4, s += channels) {
+				dst[0] = s[0];
+				dst[1] = (channels >= 3) ? s[1] : s[0];
+				dst[2] = (channels >= 3) ? s[2] : s[0];
+				dst[3] = (channels == 4) ? s[3] : (channels == 2 ? s[1] : 255);
+			}
+		}
+	}
+
+	ofBuffer buffer(data.data(), data.size());
+	if (!ofBufferToFile(path, buffer, true)) {
+		cout << "asset pack: can't write " << path << endl;
+		return false;
+	}
+	cout << "asset pack: " << n << " images in " << blocks.size() << " blocks, " << data.size() << " bytes" << endl;
+	return true;
+}
+
+//  Map the pack read only and check the index against the file size
+//
+bool AssetPack::open(const string &path) {
+	MemoryScope scope(MemAssets);
+	close();
+	string fullPath = ofToDataPath(path, true);
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(fullPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart < sizeof(PackHeader)) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		CloseHandle(file);
+		return false;
+	}
+	void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	fileHandle = file;
+	mapHandle = mapping;
+	base = (const char *)view;
+	length = size.QuadPart;
+#else
+	int fd = ::open(fullPath.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < sizeof(PackHeader)) {
+		::close(fd);
+		return false;
+	}
+	void *view = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (view == MAP_FAILED) return false;
+	base = (const char *)view;
+	length = st.st_size;
+#endif
+
+	header = (const PackHeader *)base;
+	blocks = (const PackBlock *)(base + sizeof(PackHeader));
+	entries = (const PackEntry *)(blocks + header->numBlocks);
+	size_t indexEnd = sizeof(PackHeader) + (size_t)header->numBlocks * sizeof(PackBlock) + (size_t)header->numEntries * sizeof(PackEntry);
+	bool valid = header->magic == PACK_MAGIC && header->version == PACK_VERSION && indexEnd <= length;
+	for (int b = 0; valid && b < header->numBlocks; b++) {
+		size_t bytes = (size_t)blocks[b].width * blocks[b].height * blocks[b].channels;
+		valid = blocks[b].offset >= indexEnd && blocks[b].offset + bytes <= length;
+	}
+	for (int i = 0; valid && i < header->numEntries; i++) {
+		const PackEntry &e = entries[i];
+		valid = e.block < header->numBlocks && e.x + e.width <= blocks[e.block].width && e.y + e.height <= blocks[e.block].height;
+	}
+	if (!valid) {
+		cout << "asset pack: " << path << " is not a valid pack" << endl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void AssetPack::close() {
+	if (base == NULL) return;
+#ifdef _WIN32
+	UnmapViewOfFile(base);
+	CloseHandle((HANDLE)mapHandle);
+	CloseHandle((HANDLE)fileHandle);
+#else
+	munmap((void *)base, length);
+#endif
+	base = NULL;
+	length = 0;
+	header = NULL;
+	blocks = NULL;
+	entries = NULL;
+	fileHandle = NULL;
+	mapHandle = NULL;
+}
+
+const PackEntry *AssetPack::find(const string &name) const {
+	if (base == NULL) return NULL;
+	for (int i = 0; i < header->numEntries; i++) {
+		if (strncmp(entries[i].name, name.c_str(), PACK_NAME_LEN) == 0) return &entries[i];
+	}
+	return NULL;
+}
+
+//  Fill img from the pack. Returns false if the pack is not open or does
+//  not contain name, so the caller can fall back to decoding the file.
+//
+bool AssetPack::loadImage(ofImage &img, const string &name) const {
+	MemoryScope scope(MemAssets);
+	const PackEntry *e = find(name);
+	if (e == NULL) return false;
+	const PackBlock &b = blocks[e->block];
+	const unsigned char *src = (const unsigned char *)base + b.offset;
+	ofImageType type = channelsToType(b.channels);
+
+	// a whole block is copied from the mapping in one setFromPixels() call,
+	// without cropping
+	//
+	if (e->x == 0 && e->y == 0 && e->width == b.width && e->height == b.height) {
+		img.setFromPixels(src, e->width, e->height, type);
+		return true;
+	}
+
+	ofPixels pix;
+	pix.allocate(e->width, e->height, type);
+	size_t rowBytes = e->width * b.channels;
+	for (int row = 0; row < e->height; row++)
+		memcpy(pix.getData() + row * rowBytes, src + ((size_t)(e->y + row) * b.width + e->x) * b.channels, rowBytes);
+	img.setFromPixels(pix);
+	return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "ofMain.h"
+
+//  Preprocessed image pack. The images the game uses are decoded once by a
+//  build step (run the game with --build-pack) and written to a single file
+//  that is memory mapped at startup, so loading an image is a copy out of
+//  the mapping instead of a PNG decode. Small sprites share one atlas
+//  block; full window images get a block each. The file is laid out as:
+//
+//     PackHeader
+//     PackBlock   x numBlocks   (decoded pixels, 8 bits per channel)
+//     PackEntry   x numEntries  (named rectangle inside a block)
+//     pixel data, every block starting on a 16 byte boundary
+//
+//  Only the names passed to build() are packed, so images that nothing
+//  loads never make it into the pack.
+//
+#define PACK_MAGIC        0x4b415041   // "APAK"
+#define PACK_VERSION      1
+#define PACK_NAME_LEN     48
+#define PACK_ATLAS_MAX    256          // images up to this size go in the atlas
+#define PACK_ATLAS_WIDTH  512
+
+struct PackHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numBlocks;
+	uint32_t numEntries;
+};
+
+struct PackBlock {
+	uint32_t width, height;
+	uint32_t channels;
+	uint32_t pad;
+	uint64_t offset;          // from the start of the file
+};
+
+struct PackEntry {
+	char     name[PACK_NAME_LEN];
+	uint32_t block;
+	uint32_t x, y;
+	uint32_t width, height;
+};
+
+class AssetPack {
+public:
+	AssetPack();
+	~AssetPack();
+	static bool build(const vector<string> &names, const string &path);
+	bool open(const string &path);
+	void close();
+	bool isOpen() const { return base != NULL; }
+	const PackEntry *find(const string &name) const;
+	bool loadImage(ofImage &img, const string &name) const;
+private:
+	AssetPack(const AssetPack &);
+	AssetPack &operator=(const AssetPack &);
+
+	const char *base;         // start of the mapping
+	size_t length;
+	const PackHeader *header;
+	const PackBlock *blocks;
+	const PackEntry *entries;
+	void *fileHandle;         // Windows file and mapping handles
+	void *mapHandle;
+};
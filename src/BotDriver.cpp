@@ -0,0 +1,253 @@
+#include "BotDriver.h"
+#include "ofApp.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+static const BotScenario scenarios[] = {
+	{ "normal", 3, 10, 50, 0, false },     // slider defaults, 6 shots/s
+	{ "busy", 10, 10, 150, 0, true },      // 20 shots/s
+	{ "swarm", 20, 10, 150, 4, true },     // 200 shots/s
+	{ "flood", 40, 10, 200, 9, true },     // 800 shots/s
+};
+
+static const float dodgeRadius = 160;   // pixels, shots closer than this are avoided
+static const float edgeMargin = 120;    // pixels
+static const float aimTolerance = 15;   // degrees
+
+BotDriver::BotDriver() {
+	active = false;
+	duration = 0;
+	reportInterval = 60000;
+	decisionMs = 80;
+	rounds = 0;
+	scenario = NULL;
+	haveRound = false;
+	held = 0;
+	startTime = nextDecision = nextReport = 0;
+	startSteps = startSpawns = startPairs = 0;
+	maxSprites = maxParticles = 0;
+}
+
+//  Apply the named scenario to the app; call after the waves exist
+//
+bool BotDriver::setup(ofApp &app, const string &name, float minutes) {
+	for (int i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+		if (name == scenarios[i].name) scenario = &scenarios[i];
+	if (scenario == NULL) {
+		cout << "bot: unknown scenario " << name << ", use one of:";
+		for (int i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) cout << " " << scenarios[i].name;
+		cout << endl;
+		return false;
+	}
+
+	app.leftEnemyRate = scenario->enemyRate;
+	app.rightEnemyRate = scenario->enemyRate;
+	app.leftEnemyLife = scenario->enemyLife;
+	app.rightEnemyLife = scenario->enemyLife;
+	app.leftEnemyFiringSpeed = scenario->fireSpeed;
+	app.rightEnemyFiringSpeed = scenario->fireSpeed;
+
+	//extra waves are staggered so they do not all fire on the same tick
+	double now = GameClock::millis();
+	Emitter *enemies[2] = { app.enemy, app.enemyT };
+	for (int i = 0; i < scenario->extraWaves; i++) {
+		for (int k = 0; k < 2; k++) {
+			float offset = 1000.0 / scenario->enemyRate * (i + 1) / (scenario->extraWaves + 1);
+			int w = app.scheduler.addWave(enemies[k], &app.targetImage, scenario->enemyRate, now + offset);
+			app.scheduler.waves[w].speed = scenario->fireSpeed + 100;
+			app.scheduler.waves[w].lifespan = scenario->enemyLife * 1000;
+		}
+	}
+
+	duration = minutes * 60000;
+	start(ofGetElapsedTimeMillis());
+	startSteps = app.simSteps;
+	startSpawns = app.spawnCounter->get();
+	startPairs = app.pairCounter->get();
+	active = true;
+	cout << "bot: scenario " << scenario->name << ", " << 2 * (1 + scenario->extraWaves) * scenario->enemyRate << " enemy shots/s" << endl;
+	return true;
+}
+
+//  Keys the bot wants held, as INPUT_* bits. Runs under the simulation
+//  lock; also starts and restarts rounds.
+//
+int BotDriver::decide(ofApp &app) {
+	if (app.game_state != "game") {
+		if (haveRound) {
+			round.restore(app);
+			app.scheduler.resync(GameClock::millis());
+			rounds++;
+		}
+		return 0;
+	}
+	if (!haveRound) {
+		round.save(app);
+		haveRound = true;
+	}
+
+	Emitter *turret = app.turret;
+	if (scenario->keepAlive) app.health.set(turret->healthSlot, MAX(app.health.get(turret->healthSlot), 100));
+	ofVec3f pos = turret->trans;
+	ofVec3f head = turret->head, left = turret->left;
+
+	//get away from the closest shot and from the edges
+	ofVec3f away(0, 0, 0);
+	float closest = dodgeRadius;
+	Emitter *enemies[2] = { app.enemy, app.enemyT };
+	for (int k = 0; k < 2; k++) {
+		const vector<Sprite> &shots = enemies[k]->sys->sprites;
+		for (int i = 0; i < shots.size(); i++) {
+			ofVec3f d = pos - ofVec3f(shots[i].trans);
+			float dist = d.length();
+			if (dist < closest && dist > 0) {
+				closest = dist;
+				away = d / dist;
+			}
+		}
+	}
+	float w = app.playWidth(), h = app.playHeight();
+	if (pos.x < edgeMargin) away.x += 1;
+	if (pos.x > w - edgeMargin) away.x -= 1;
+	if (pos.y < edgeMargin) away.y += 1;
+	if (pos.y > h - edgeMargin) away.y -= 1;
+
+	int keys = INPUT_FIRE;
+	if (away.lengthSquared() > 0) {
+		float forward = away.dot(head), side = away.dot(left);
+		if (forward > 0.3) keys |= INPUT_UP;
+		if (forward < -0.3) keys |= INPUT_DOWN;
+		if (side > 0.3) keys |= INPUT_RIGHT;
+		if (side < -0.3) keys |= INPUT_LEFT;
+		return keys;
+	}
+
+	//nothing to dodge: turn toward the closest enemy still alive
+	Emitter *target = NULL;
+	float best = 0;
+	for (int k = 0; k < 2; k++) {
+		float dist = pos.distance(enemies[k]->trans);
+		if (app.health.isAlive(enemies[k]->healthSlot) && (target == NULL || dist < best)) {
+			target = enemies[k];
+			best = dist;
+		}
+	}
+	if (target != NULL) {
+		ofVec3f d = (ofVec3f(target->trans) - pos).getNormalized();
+		float cross = head.x * d.y - head.y * d.x;
+		float angle = ofRadToDeg(atan2(cross, head.dot(d)));
+		if (angle > aimTolerance) keys |= INPUT_ROTATE_RIGHT;
+		if (angle < -aimTolerance) keys |= INPUT_ROTATE_LEFT;
+	}
+	return keys;
+}
+
+//  Any key release puts the turret back to idle, so when the wanted keys
+//  change all movement keys are released and the wanted ones pressed again,
+//  vertical first so diagonals combine as they do for a player.
+//
+void BotDriver::setKeys(ofApp &app, int keys) {
+	static const int bits[] = { INPUT_UP, INPUT_DOWN, INPUT_LEFT, INPUT_RIGHT, INPUT_ROTATE_LEFT, INPUT_ROTATE_RIGHT };
+	static const int codes[] = { OF_KEY_UP, OF_KEY_DOWN, OF_KEY_LEFT, OF_KEY_RIGHT, ',', '.' };
+	int moves = keys & ~INPUT_FIRE;
+	if (moves != (held & ~INPUT_FIRE)) {
+		for (int i = 0; i < 6; i++)
+			if (held & bits[i]) app.keyReleased(codes[i]);
+		for (int i = 0; i < 6; i++)
+			if (moves & bits[i]) app.keyPressed(codes[i]);
+	}
+	if ((keys & INPUT_FIRE) && !(held & INPUT_FIRE)) app.keyPressed(' ');
+	if (!(keys & INPUT_FIRE) && (held & INPUT_FIRE)) app.keyReleased(' ');
+	held = keys;
+}
+
+//  Restart the clocks for duration, decisions and reports
+//
+void BotDriver::start(float now) {
+	startTime = now;
+	nextDecision = now;
+	nextReport = now + reportInterval;
+}
+
+void BotDriver::update(ofApp &app) {
+	float now = ofGetElapsedTimeMillis();
+	if (now >= nextReport) {
+		report(app);
+		nextReport += reportInterval;
+	}
+	if (duration > 0 && now - startTime >= duration) {
+		report(app);
+		active = false;
+		ofExit(app.allocFailures > 0 ? 1 : 0);
+		return;
+	}
+	if (now < nextDecision) return;
+	nextDecision = now + decisionMs;
+
+	int keys;
+	string state;
+	{
+		std::lock_guard<std::mutex> lock(app.simMutex);
+		keys = decide(app);
+		state = app.game_state;
+		maxSprites = MAX(maxSprites, app.turret->sys->sprites.size() + app.enemy->sys->sprites.size() + app.enemyT->sys->sprites.size());
+		maxParticles = MAX(maxParticles, app.explosion.sys->particles.size());
+	}
+
+	//the start screen is left by releasing space
+	if (state == "start") {
+		app.keyPressed(' ');
+		app.keyReleased(' ');
+		held = 0;
+		return;
+	}
+	setKeys(app, keys);
+}
+
+//  One line of totals since the bot started; frame times are in ms
+//
+void BotDriver::report(ofApp &app) {
+	MemoryScope scope(MemUI);
+	float seconds = (ofGetElapsedTimeMillis() - startTime) / 1000.0;
+	if (seconds <= 0) return;
+	MetricHistogram *frames = app.frameHistogram;
+	cout << "bot: " << (int)seconds << " s, " << rounds << " rounds"
+		<< ", steps/s " << (app.simSteps - startSteps) / seconds
+		<< ", spawns/s " << (app.spawnCounter->get() - startSpawns) / seconds
+		<< ", pairs/s " << (app.pairCounter->get() - startPairs) / seconds
+		<< ", frame p50/p90/p99/max " << frames->percentile(0.5) / 1000.0 << "/" << frames->percentile(0.9) / 1000.0
+		<< "/" << frames->percentile(0.99) / 1000.0 << "/" << frames->percentile(1) / 1000.0
+		<< ", update p99 " << app.updateHistogram->percentile(0.99) / 1000.0
+		<< ", draw p99 " << app.drawHistogram->percentile(0.99) / 1000.0
+		<< ", max sprites " << maxSprites << ", max particles " << maxParticles
+		<< ", peak rss " << peakMemoryKB() / 1024 << " MB"
+		<< ", effect level " << app.budget.level.load()
+		<< ", event overflows " << app.events.overflows->get() << endl;
+	cout << "bot: heap " << MemoryTracker::summary()
+		<< ", allocations/frame p50/p99/max " << app.allocHistogram->percentile(0.5) << "/" << app.allocHistogram->percentile(0.99)
+		<< "/" << app.allocHistogram->percentile(1) << ", frames over limit " << app.allocFailures
+		<< ", tick arena peak " << app.tickArena.highWater / 1024 << "/" << app.tickArena.capacity() / 1024 << " KB, overflows " << app.tickArena.overflows << endl;
+}
+
+uint64_t BotDriver::peakMemoryKB() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return counters.PeakWorkingSetSize / 1024;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+	return usage.ru_maxrss / 1024;   // bytes on macOS
+#else
+	return usage.ru_maxrss;
+#endif
+#endif
+}
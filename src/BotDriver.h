@@ -0,0 +1,60 @@
+#pragma once
+#include "ofMain.h"
+#include "GameSnapshot.h"
+#include "Metrics.h"
+
+class ofApp;
+
+//  Load preset for a bot run. The enemies' sliders are set from it and
+//  extraWaves more spawn waves are added to each enemy, so enemy shots are
+//  spawned at 2 * (1 + extraWaves) * enemyRate per second. At most that
+//  times enemyLife are alive at once; shots that hit the player or are shot
+//  down go sooner.
+//
+struct BotScenario {
+	const char *name;
+	float enemyRate;     // shots/sec per wave
+	float enemyLife;     // sec
+	float fireSpeed;     // pixels/sec
+	int extraWaves;      // per enemy
+	bool keepAlive;      // the turret's life is topped up so shots can pile up
+};
+
+//  Plays the turret for unattended stress runs. Every decision interval the
+//  bot looks at the game, picks the keys it wants held (dodge the closest
+//  enemy shot, keep away from the edges, turn toward the nearest enemy, fire
+//  all the time) and sends the changes through ofApp::keyPressed() and
+//  keyReleased(), the same path as a player. When a round ends it restores
+//  the state saved when the first round started, so a run can go on for
+//  hours.
+//
+//  Throughput, frame time percentiles, high water marks for entities and
+//  memory, and heap use per MemoryTracker tag are printed every report
+//  interval and when the run ends. With ofApp::allocLimit set, the process
+//  exits with status 1 if any gameplay frame went over it.
+//
+class BotDriver {
+public:
+	BotDriver();
+	bool setup(ofApp &app, const string &scenario, float minutes);
+	void update(ofApp &app);
+	void report(ofApp &app);
+	void start(float now);
+	static uint64_t peakMemoryKB();
+
+	bool active;
+	float duration;        // ms, 0 => until the app is closed
+	float reportInterval;  // ms
+	float decisionMs;
+	int rounds;
+private:
+	int decide(ofApp &app);
+	void setKeys(ofApp &app, int keys);
+	const BotScenario *scenario;
+	GameSnapshot round;    // state when the first round started
+	bool haveRound;
+	int held;              // INPUT_* bits currently pressed
+	float startTime, nextDecision, nextReport;
+	uint64_t startSteps, startSpawns, startPairs;
+	size_t maxSprites, maxParticles;
+};
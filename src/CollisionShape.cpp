@@ -0,0 +1,198 @@
+#include "CollisionShape.h"
+
+CollisionShape::CollisionShape() {
+	type = ShapeCircle;
+	radius = 0;
+}
+
+CollisionShape CollisionShape::circle(float radius) {
+	CollisionShape shape;
+	shape.radius = radius;
+	return shape;
+}
+
+CollisionShape CollisionShape::box(float width, float height) {
+	CollisionShape shape;
+	shape.type = ShapeBox;
+	shape.half = float2(width / 2, height / 2);
+	shape.radius = sqrt(shape.half.lengthSquared());
+	return shape;
+}
+
+CollisionShape CollisionShape::orientedBox(float width, float height) {
+	CollisionShape shape = box(width, height);
+	shape.type = ShapeOrientedBox;
+	return shape;
+}
+
+static bool pointBefore(const float2 &a, const float2 &b) {
+	return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+static float cross(const float2 &o, const float2 &a, const float2 &b) {
+	return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+//  Trace the convex hull of the pixels with at least alphaThreshold alpha.
+//  Only the first and last opaque pixel of each row can be on the hull, so
+//  their outer corners are collected and wrapped with a monotone chain.
+//  Corners cutting off the least area are then dropped until at most
+//  HULL_MAX_POINTS are left. Images without alpha get an oriented box.
+//  Returns false, leaving the shape as it was, for an empty image.
+//
+bool CollisionShape::setFromImage(const ofImage &image, int alphaThreshold) {
+	const ofPixels &pix = image.getPixels();
+	if (!pix.isAllocated()) return false;
+	int w = pix.getWidth();
+	int h = pix.getHeight();
+	int channels = pix.getNumChannels();
+	if (channels != 4) {
+		*this = orientedBox(w, h);
+		return true;
+	}
+
+	const unsigned char *data = pix.getData();
+	vector<float2> corners;
+	float ox = w / 2.0, oy = h / 2.0;
+	for (int y = 0; y < h; y++) {
+		const unsigned char *row = data + y * w * 4;
+		int first = -1, last = -1;
+		for (int x = 0; x < w; x++) {
+			if (row[x * 4 + 3] < alphaThreshold) continue;
+			if (first < 0) first = x;
+			last = x;
+		}
+		if (first < 0) continue;
+		corners.push_back(float2(first - ox, y - oy));
+		corners.push_back(float2(first - ox, y + 1 - oy));
+		corners.push_back(float2(last + 1 - ox, y - oy));
+		corners.push_back(float2(last + 1 - ox, y + 1 - oy));
+	}
+	if (corners.empty()) return false;
+
+	std::sort(corners.begin(), corners.end(), pointBefore);
+	vector<float2> hull(corners.size() * 2);
+	int k = 0;
+	for (int i = 0; i < corners.size(); i++) {
+		while (k >= 2 && cross(hull[k - 2], hull[k - 1], corners[i]) <= 0) k--;
+		hull[k++] = corners[i];
+	}
+	for (int i = corners.size() - 2, lower = k + 1; i >= 0; i--) {
+		while (k >= lower && cross(hull[k - 2], hull[k - 1], corners[i]) <= 0) k--;
+		hull[k++] = corners[i];
+	}
+	hull.resize(k - 1);
+
+	while (hull.size() > HULL_MAX_POINTS) {
+		int n = hull.size(), drop = 0;
+		float smallest = FLT_MAX;
+		for (int i = 0; i < n; i++) {
+			float area = fabs(cross(hull[(i + n - 1) % n], hull[i], hull[(i + 1) % n]));
+			if (area < smallest) {
+				smallest = area;
+				drop = i;
+			}
+		}
+		hull.erase(hull.begin() + drop);
+	}
+
+	type = ShapeHull;
+	points = hull;
+	half = float2();
+	radius = 0;
+	for (int i = 0; i < points.size(); i++) {
+		half.x = MAX(half.x, fabs(points[i].x));
+		half.y = MAX(half.y, fabs(points[i].y));
+		radius = MAX(radius, points[i].lengthSquared());
+	}
+	radius = sqrt(radius);
+	return true;
+}
+
+//  Corners of a box or hull in world coordinates; out needs room for
+//  HULL_MAX_POINTS. Returns the number of corners.
+//
+static int worldCorners(const CollisionShape &shape, const ShapePose &pose, float2 *out) {
+	float2 box[4] = {
+		float2(-shape.half.x, -shape.half.y), float2(shape.half.x, -shape.half.y),
+		float2(shape.half.x, shape.half.y), float2(-shape.half.x, shape.half.y)
+	};
+	const float2 *local = (shape.type == ShapeHull) ? shape.points.data() : box;
+	int n = (shape.type == ShapeHull) ? shape.points.size() : 4;
+	float c = pose.c, s = pose.s;
+	if (shape.type == ShapeBox) {
+		c = 1;
+		s = 0;
+	}
+	for (int i = 0; i < n; i++)
+		out[i] = pose.pos + float2(c * local[i].x - s * local[i].y, s * local[i].x + c * local[i].y);
+	return n;
+}
+
+//  True if one of a's edge normals separates the two convex polygons
+//
+static bool edgeSeparates(const float2 *a, int na, const float2 *b, int nb) {
+	for (int i = 0; i < na; i++) {
+		float2 edge = a[(i + 1) % na] - a[i];
+		float2 axis(-edge.y, edge.x);
+		float minA = FLT_MAX, maxA = -FLT_MAX, minB = FLT_MAX, maxB = -FLT_MAX;
+		for (int j = 0; j < na; j++) {
+			float d = axis.dot(a[j]);
+			minA = MIN(minA, d);
+			maxA = MAX(maxA, d);
+		}
+		for (int j = 0; j < nb; j++) {
+			float d = axis.dot(b[j]);
+			minB = MIN(minB, d);
+			maxB = MAX(maxB, d);
+		}
+		if (maxA < minB || maxB < minA) return true;
+	}
+	return false;
+}
+
+//  The circle touches the polygon if its center is inside (on the same side
+//  of every edge) or an edge passes within radius of the center.
+//
+static bool circleTouchesPolygon(const float2 &center, float radius, const float2 *p, int n) {
+	float r2 = radius * radius;
+	float side = 0;
+	bool inside = true;
+	for (int i = 0; i < n; i++) {
+		float2 a = p[i], ab = p[(i + 1) % n] - a, ac = center - a;
+		float turn = ab.x * ac.y - ab.y * ac.x;
+		if (side == 0) side = turn;
+		else if ((turn > 0) != (side > 0) && turn != 0) inside = false;
+		float len2 = ab.lengthSquared();
+		float t = (len2 > 0) ? ofClamp(ac.dot(ab) / len2, 0, 1) : 0;
+		if ((a + ab * t).distanceSquared(center) <= r2) return true;
+	}
+	return inside;
+}
+
+//  Exact overlap test, after a bounding circle early out
+//
+bool shapesOverlap(const CollisionShape &a, const ShapePose &pa, const CollisionShape &b, const ShapePose &pb) {
+	float reach = a.radius + b.radius;
+	if (pa.pos.distanceSquared(pb.pos) > reach * reach) return false;
+	if (a.type == ShapeCircle && b.type == ShapeCircle) return true;
+	if (a.type != ShapeCircle && b.type == ShapeCircle) return shapesOverlap(b, pb, a, pa);
+
+	if (a.type == ShapeBox && b.type == ShapeBox) {
+		float2 d = pb.pos - pa.pos;
+		return fabs(d.x) <= a.half.x + b.half.x && fabs(d.y) <= a.half.y + b.half.y;
+	}
+	if (a.type == ShapeCircle && b.type == ShapeBox) {
+		float2 nearest(ofClamp(pa.pos.x, pb.pos.x - b.half.x, pb.pos.x + b.half.x),
+			ofClamp(pa.pos.y, pb.pos.y - b.half.y, pb.pos.y + b.half.y));
+		return nearest.distanceSquared(pa.pos) <= a.radius * a.radius;
+	}
+
+	float2 cb[HULL_MAX_POINTS];
+	int nb = worldCorners(b, pb, cb);
+	if (a.type == ShapeCircle) return circleTouchesPolygon(pa.pos, a.radius, cb, nb);
+
+	float2 ca[HULL_MAX_POINTS];
+	int na = worldCorners(a, pa, ca);
+	return !edgeSeparates(ca, na, cb, nb) && !edgeSeparates(cb, nb, ca, na);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "ofMain.h"
+#include "VecMath.h"
+
+#define HULL_MAX_POINTS 12   // corners kept when tracing an image
+
+//  Hitbox of a game object, in the object's local frame (pixels, centered
+//  on the object's position like its image):
+//
+//     ShapeCircle       circle of radius
+//     ShapeBox          axis aligned box, does not turn with its object
+//     ShapeOrientedBox  box that turns with its object
+//     ShapeHull         convex polygon, e.g. traced from an image's alpha
+//
+//  Every shape also keeps the radius of a circle around the local origin
+//  that contains it. shapesOverlap() rejects pairs whose bounding circles
+//  are apart before running the exact test, and batch queries can use the
+//  summed radii with withinRadius() as a broad phase.
+//
+typedef enum { ShapeCircle, ShapeBox, ShapeOrientedBox, ShapeHull } ShapeType;
+
+class CollisionShape {
+public:
+	CollisionShape();
+	static CollisionShape circle(float radius);
+	static CollisionShape box(float width, float height);
+	static CollisionShape orientedBox(float width, float height);
+	bool setFromImage(const ofImage &image, int alphaThreshold = 128);
+
+	ShapeType type;
+	float radius;            // bounding circle
+	float2 half;             // half width and height of the boxes
+	vector<float2> points;   // hull corners in order around it, at most HULL_MAX_POINTS
+};
+
+//  Where a shape is in the world: position plus the cos and sin of its
+//  object's rotation (the scene graph's worldCos/worldSin).
+//
+struct ShapePose {
+	float2 pos;
+	float c, s;
+	ShapePose() : c(1), s(0) {}
+	explicit ShapePose(const float2 &pos, float c = 1, float s = 0) : pos(pos), c(c), s(s) {}
+};
+
+bool shapesOverlap(const CollisionShape &a, const ShapePose &pa, const CollisionShape &b, const ShapePose &pb);
@@ -0,0 +1,93 @@
+#include "EffectBudget.h"
+
+// fraction of the requested effect kept at each quality level, and how many
+// frames apart turbulence is evaluated (0 = never)
+//
+static const float levelScale[EFFECT_LEVELS] = { 0.15, 0.35, 0.6, 1.0 };
+static const int turbulenceStride[EFFECT_LEVELS] = { 0, 4, 2, 1 };
+
+// frames the budget has to be missed (or comfortably met) before the
+// level changes, so a single slow frame does not cause flicker
+//
+static const int framesToLower = 5;
+static const int framesToRaise = 60;
+
+EffectBudget::EffectBudget() {
+	targetFrameMs = 1000.0 / 60.0;
+	maxParticles = 2000;
+	level = EFFECT_LEVELS - 1;
+	throttleCount = 0;
+	frameMs = 0;
+	updateMs = 0;
+	drawMs = 0;
+	loopMs = 0;
+	updateStart = 0;
+	drawStart = 0;
+	overFrames = 0;
+	underFrames = 0;
+	frame = 0;
+}
+
+void EffectBudget::beginUpdate() {
+	updateStart = ofGetElapsedTimeMicros();
+}
+
+void EffectBudget::endUpdate() {
+	updateMs = (ofGetElapsedTimeMicros() - updateStart) / 1000.0;
+}
+
+void EffectBudget::beginDraw() {
+	drawStart = ofGetElapsedTimeMicros();
+}
+
+void EffectBudget::endDraw() {
+	drawMs = (ofGetElapsedTimeMicros() - drawStart) / 1000.0;
+	loopMs = ofGetLastFrameTime() * 1000;
+}
+
+//  Called once per frame after update and draw have been measured.
+//
+void EffectBudget::adjust() {
+	frame++;
+	float ms = updateMs + drawMs;
+	frameMs = (frameMs == 0) ? ms : frameMs * 0.9 + ms * 0.1;
+
+	if (frameMs > targetFrameMs) {
+		underFrames = 0;
+		if (++overFrames >= framesToLower && level > 0) {
+			level--;
+			throttleCount++;
+			overFrames = 0;
+		}
+	}
+	else if (frameMs < targetFrameMs * 0.7) {
+		overFrames = 0;
+		if (++underFrames >= framesToRaise && level < EFFECT_LEVELS - 1) {
+			level++;
+			underFrames = 0;
+		}
+	}
+	else {
+		overFrames = 0;
+		underFrames = 0;
+	}
+}
+
+int EffectBudget::groupSize(int requested) const {
+	return MAX(1, (int)(requested * levelScale[level] + 0.5));
+}
+
+int EffectBudget::particleCap() const {
+	return maxParticles * levelScale[level];
+}
+
+//  Enemy fire is gameplay, so it is never scaled below half rate
+//
+float EffectBudget::spawnRateScale() const {
+	return MAX(0.5f, levelScale[level]);
+}
+
+bool EffectBudget::evaluateTurbulence() const {
+	int stride = turbulenceStride[level];
+	return stride != 0 && frame % stride == 0;
+}
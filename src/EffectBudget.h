@@ -0,0 +1,43 @@
+#pragma once
+#include "ofMain.h"
+#include <atomic>
+
+//  Adaptive effect budget. Watches the measured update + draw time of each
+//  frame and steps a discrete quality level up or down to hold a target
+//  frame time. The level scales particle group sizes, the global particle
+//  cap, enemy spawn rates and how often turbulence is evaluated.
+//
+//  Level EFFECT_LEVELS - 1 is full quality, 0 is the most degraded.
+//
+//  With --threaded, update is measured and adjust() runs on the simulation
+//  thread while draw is measured on the main thread, so the values read
+//  across threads are atomic.
+//
+#define EFFECT_LEVELS 4
+
+class EffectBudget {
+public:
+	EffectBudget();
+	void beginUpdate();
+	void endUpdate();
+	void beginDraw();
+	void endDraw();
+	void adjust();
+
+	int groupSize(int requested) const;
+	int particleCap() const;
+	float spawnRateScale() const;
+	bool evaluateTurbulence() const;
+
+	float targetFrameMs;     // frame time budget for update + draw
+	int maxParticles;        // particle cap at full quality
+	std::atomic<int> level;            // current quality level
+	std::atomic<int> throttleCount;    // number of times the level was lowered
+	float frameMs;                     // smoothed update + draw time
+	std::atomic<float> updateMs, drawMs;  // last measured times
+	std::atomic<float> loopMs;         // last main loop frame (ofGetLastFrameTime)
+private:
+	uint64_t updateStart, drawStart;
+	int overFrames, underFrames;
+	uint64_t frame;
+};
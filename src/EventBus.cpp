@@ -0,0 +1,82 @@
+#include "EventBus.h"
+
+//  capacity is rounded up to a power of two so indices wrap with a mask
+//
+EventRing::EventRing(int capacity) {
+	int n = 1;
+	while (n < capacity) n <<= 1;
+	slots.resize(n);
+	mask = n - 1;
+	head.store(0, std::memory_order_relaxed);
+	tail.store(0, std::memory_order_relaxed);
+}
+
+bool EventRing::push(const GameEvent &e) {
+	uint32_t h = head.load(std::memory_order_relaxed);
+	uint32_t t = tail.load(std::memory_order_acquire);
+	if (h - t > mask) return false;
+	slots[h & mask] = e;
+	head.store(h + 1, std::memory_order_release);
+	return true;
+}
+
+int EventRing::pop(GameEvent *out, int max) {
+	uint32_t t = tail.load(std::memory_order_relaxed);
+	uint32_t h = head.load(std::memory_order_acquire);
+	int n = MIN((int)(h - t), max);
+	for (int i = 0; i < n; i++)
+		out[i] = slots[(t + i) & mask];
+	tail.store(t + n, std::memory_order_release);
+	return n;
+}
+
+int EventRing::size() const {
+	return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+}
+
+//  Double the capacity, keeping the queued events in order
+//
+void EventRing::grow() {
+	uint32_t t = tail.load(std::memory_order_relaxed);
+	uint32_t h = head.load(std::memory_order_relaxed);
+	vector<GameEvent> bigger(slots.size() * 2);
+	for (uint32_t i = 0; i < h - t; i++)
+		bigger[i] = slots[(t + i) & mask];
+	slots.swap(bigger);
+	mask = slots.size() - 1;
+	tail.store(0, std::memory_order_relaxed);
+	head.store(h - t, std::memory_order_release);
+}
+
+EventBus::EventBus(int capacity) : ring(capacity) {
+	overflows = NULL;
+	batch.resize(ring.capacity());
+}
+
+void EventBus::publish(GameEventType type, int target, int amount, const glm::vec3 &pos) {
+	GameEvent e;
+	e.type = type;
+	e.target = target;
+	e.amount = amount;
+	e.pos = pos;
+	if (ring.push(e)) return;
+
+	if (overflows) overflows->add();
+	ring.grow();
+	ring.push(e);
+}
+
+void EventBus::subscribe(const EventHandler &handler) {
+	handlers.push_back(handler);
+}
+
+//  Drain everything published so far and hand it to each subscriber.
+//  Events published by the handlers wait for the next dispatch().
+//
+void EventBus::dispatch() {
+	if (batch.size() < ring.capacity()) batch.resize(ring.capacity());
+	int n = ring.pop(batch.data(), batch.size());
+	if (n == 0) return;
+	for (int i = 0; i < handlers.size(); i++)
+		handlers[i](batch.data(), n);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "ofMain.h"
+#include <atomic>
+#include <functional>
+#include "Metrics.h"
+
+//  Gameplay events. Collision and spawning only publish these; score,
+//  damage, audio, effects and metrics are applied by subscribers when the
+//  bus is dispatched.
+//
+typedef enum {
+	EventShotHit,        // player shot destroyed an enemy shot
+	EventEmitterHit,     // player shot hit an enemy emitter
+	EventPlayerHit,      // enemy shot hit the player
+	EventPlayerCrash,    // player ran into an enemy emitter
+	EventSpawn,          // a wave fired a sprite
+} GameEventType;
+
+struct GameEvent {
+	GameEventType type;
+	int target;          // emitter index (0 turret, 1 left, 2 right) or wave index for EventSpawn
+	int amount;          // damage dealt
+	glm::vec3 pos;       // where it happened
+};
+
+//  Single producer, single consumer ring of events. push() and pop() never
+//  block or allocate; the producer only writes head and the consumer only
+//  writes tail, so the two sides can be on different threads. grow()
+//  moves the slots, so it is only safe while nothing else touches the ring.
+//
+class EventRing {
+public:
+	EventRing(int capacity);
+	bool push(const GameEvent &e);
+	int pop(GameEvent *out, int max);
+	int size() const;
+	int capacity() const { return mask + 1; }
+	void grow();
+private:
+	vector<GameEvent> slots;
+	uint32_t mask;
+	alignas(64) std::atomic<uint32_t> head;   // next slot to write
+	alignas(64) std::atomic<uint32_t> tail;   // next slot to read
+};
+
+//  Events are published into the ring as they happen and delivered to
+//  every subscriber in one batch per dispatch(), in publish order. A
+//  subscriber that runs on another thread can copy the batch into its own
+//  EventRing.
+//
+//  Gameplay events must not be lost, and the game relies on them waiting
+//  for dispatch() (e.g. until all collisions of a tick are found). So
+//  publish() and dispatch() run on the same thread, and a full ring is
+//  doubled in place; the growths are counted in overflows.
+//
+typedef std::function<void(const GameEvent *events, int count)> EventHandler;
+
+class EventBus {
+public:
+	EventBus(int capacity = 16384);
+	void publish(GameEventType type, int target, int amount, const glm::vec3 &pos);
+	void subscribe(const EventHandler &handler);
+	void dispatch();
+
+	MetricCounter *overflows;   // times the ring was full and grown, may be NULL
+private:
+	EventRing ring;
+	vector<GameEvent> batch;
+	vector<EventHandler> handlers;
+};
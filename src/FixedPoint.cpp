@@ -0,0 +1,26 @@
+#include "FixedPoint.h"
+
+//  Bhaskara's approximation on [0, pi], mirrored for [pi, 2 pi]:
+//
+//     sin(x) ~= 16 x (pi - x) / (5 pi^2 - 4 x (pi - x))
+//
+//  The error is below 0.002 everywhere, and it only needs integer
+//  multiplies and one divide.
+//
+fixed16 fixedSin(fixed16 radians) {
+	fixed16 x = radians % FIXED_TWO_PI;
+	if (x < 0) x += FIXED_TWO_PI;
+	bool negate = false;
+	if (x > FIXED_PI) {
+		x -= FIXED_PI;
+		negate = true;
+	}
+	int64_t p = fixedMul(x, FIXED_PI - x);
+	int64_t piSquared = fixedMul(FIXED_PI, FIXED_PI);
+	fixed16 s = (fixed16)((16 * p * FIXED_ONE) / (5 * piSquared - 4 * p));
+	return negate ? -s : s;
+}
+
+fixed16 fixedCos(fixed16 radians) {
+	return fixedSin(radians + FIXED_HALF_PI);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "ofMain.h"
+
+//  16.16 fixed point numbers for the deterministic simulation mode. All
+//  arithmetic is integer, so every machine produces bit identical results
+//  regardless of compiler, FPU settings or math library. The range is
+//  about +-32768, enough for screen coordinates, speeds and angles.
+//
+typedef int32_t fixed16;
+
+#define FIXED_SHIFT       16
+#define FIXED_ONE         (1 << FIXED_SHIFT)
+#define FIXED_HALF_PI     102944        // pi / 2 * 65536
+#define FIXED_PI          205887
+#define FIXED_TWO_PI      411775
+#define FIXED_DEG_TO_RAD  1144          // pi / 180 * 65536
+
+inline fixed16 toFixed(float f) { return (fixed16)lrintf(f * FIXED_ONE); }
+inline float toFloat(fixed16 f) { return f / (float)FIXED_ONE; }
+inline fixed16 fixedMul(fixed16 a, fixed16 b) { return (fixed16)(((int64_t)a * b) >> FIXED_SHIFT); }
+inline fixed16 fixedDiv(fixed16 a, fixed16 b) { return (fixed16)(((int64_t)a * FIXED_ONE) / b); }
+
+fixed16 fixedSin(fixed16 radians);
+fixed16 fixedCos(fixed16 radians);
+
+//  Fixed point copy of an Emitter's motion state, integrated instead of the
+//  floats in deterministic mode. Rotation is in degrees.
+//
+struct FixedBody {
+	fixed16 x, y, vx, vy, ax, ay;
+	fixed16 rotation, angularVelocity, angularAcceleration;
+};
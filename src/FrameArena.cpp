@@ -0,0 +1,47 @@
+#include "FrameArena.h"
+
+FrameArena::FrameArena(size_t capacity) {
+	size = capacity;
+	block = new char[size];
+	offset = 0;
+	spillBytes = 0;
+	highWater = 0;
+	overflows = 0;
+}
+
+FrameArena::~FrameArena() {
+	for (int i = 0; i < spill.size(); i++) delete[] spill[i];
+	delete[] block;
+}
+
+void *FrameArena::allocate(size_t bytes, size_t align) {
+	size_t start = (offset + align - 1) & ~(align - 1);
+	if (start + bytes <= size) {
+		offset = start + bytes;
+		return block + start;
+	}
+
+	//full: this tick's remaining scratch comes from the heap
+	char *p = new char[bytes + align];
+	spill.push_back(p);
+	spillBytes += bytes + align;
+	return (void *)(((uintptr_t)p + align - 1) & ~(uintptr_t)(align - 1));
+}
+
+//  Everything allocated since the last reset() is gone after this
+//
+void FrameArena::reset() {
+	highWater = MAX(highWater, used());
+	if (!spill.empty()) {
+		for (int i = 0; i < spill.size(); i++) delete[] spill[i];
+		spill.clear();
+		overflows++;
+
+		//grow so the next tick like this one fits
+		delete[] block;
+		size = MAX(size * 2, highWater + highWater / 2);
+		block = new char[size];
+	}
+	offset = 0;
+	spillBytes = 0;
+}
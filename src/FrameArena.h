@@ -0,0 +1,56 @@
+#pragma once
+#include "ofMain.h"
+#include <cstddef>
+
+//  Linear allocator for memory that only lives for one simulation tick.
+//  allocate() bumps an offset into one block and reset() at the end of the
+//  tick takes it back to zero, so scratch arrays cost a pointer add and
+//  never reach the general heap.
+//
+//  When a tick needs more than the block holds, the rest is taken from the
+//  heap and counted in overflows; the next reset() frees it and grows the
+//  block to the high water mark, so after warm up the heap is not touched.
+//
+//  Nothing is destructed: only put trivially destructible data here, or
+//  containers that use ArenaAllocator.
+//
+class FrameArena {
+public:
+	FrameArena(size_t capacity = 64 * 1024);
+	~FrameArena();
+	void *allocate(size_t size, size_t align = alignof(std::max_align_t));
+	template<class T> T *allocArray(size_t n) { return (T *)allocate(n * sizeof(T), alignof(T)); }
+	void reset();
+
+	size_t capacity() const { return size; }
+	size_t used() const { return offset + spillBytes; }
+	size_t highWater;      // most bytes used in one tick
+	int overflows;         // ticks that spilled onto the heap
+private:
+	FrameArena(const FrameArena &);
+	FrameArena &operator=(const FrameArena &);
+	char *block;
+	size_t size, offset;
+	vector<char *> spill;  // heap blocks handed out after the block filled up
+	size_t spillBytes;
+};
+
+//  STL allocator drawing from a FrameArena. deallocate() does nothing, so a
+//  growing container leaves its old buffers behind until reset(); reserve
+//  up front where the size is known.
+//
+//     FrameVector<int> hits(arena);
+//
+template<class T> class ArenaAllocator {
+public:
+	typedef T value_type;
+	ArenaAllocator(FrameArena &a) : arena(&a) {}
+	template<class U> ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+	T *allocate(size_t n) { return arena->allocArray<T>(n); }
+	void deallocate(T *, size_t) {}
+	template<class U> bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+	template<class U> bool operator!=(const ArenaAllocator<U> &other) const { return arena != other.arena; }
+	FrameArena *arena;
+};
+
+template<class T> using FrameVector = vector<T, ArenaAllocator<T>>;
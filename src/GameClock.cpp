@@ -0,0 +1,34 @@
+#include "GameClock.h"
+
+static float fixedStepMs = 0;
+static uint32_t ticks = 0;
+
+double GameClock::millis() {
+	if (fixedStepMs > 0) return ticks * fixedStepMs;
+	return ofGetElapsedTimeMillis();
+}
+
+void GameClock::setFixedStep(float stepMs) {
+	fixedStepMs = stepMs;
+	ticks = 0;
+}
+
+bool GameClock::isFixed() {
+	return fixedStepMs > 0;
+}
+
+float GameClock::stepMillis() {
+	return fixedStepMs;
+}
+
+void GameClock::step() {
+	ticks++;
+}
+
+uint32_t GameClock::tick() {
+	return ticks;
+}
+
+void GameClock::setTick(uint32_t tick) {
+	ticks = tick;
+}
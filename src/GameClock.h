@@ -0,0 +1,19 @@
+#pragma once
+#include "ofMain.h"
+
+//  Time source for everything the simulation does. By default it is the
+//  wall clock. In fixed step mode time only moves when step() is called,
+//  by exactly one step, starting from zero, so a simulation driven by the
+//  same inputs sees the same times on every machine.
+//
+class GameClock {
+public:
+	static double millis();                    // double keeps sub-ms steps after hours
+	static float seconds() { return millis() / 1000.0f; }
+	static void setFixedStep(float stepMs);   // 0 => wall clock
+	static bool isFixed();
+	static float stepMillis();
+	static void step();
+	static uint32_t tick();                    // steps taken in fixed mode
+	static void setTick(uint32_t tick);        // rewind for snapshots and rollback
+};
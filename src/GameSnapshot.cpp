@@ -0,0 +1,226 @@
+#include "GameSnapshot.h"
+#include "ofApp.h"
+
+// particles are copied as raw memory, so they must stay plain data
+//
+static_assert(std::is_trivially_copyable<Particle>::value, "Particle must be trivially copyable for snapshots");
+
+static void writeVec(float *dst, const glm::vec3 &v) {
+	dst[0] = v.x;
+	dst[1] = v.y;
+	dst[2] = v.z;
+}
+
+static glm::vec3 readVec(const float *src) {
+	return glm::vec3(src[0], src[1], src[2]);
+}
+
+int GameSnapshot::stateToInt(const string &state) {
+	if (state == "game") return 1;
+	if (state == "end") return 2;
+	if (state == "win") return 3;
+	return 0;
+}
+
+string GameSnapshot::intToState(int state) {
+	switch (state) {
+	case 1: return "game";
+	case 2: return "end";
+	case 3: return "win";
+	default: return "start";
+	}
+}
+
+//  Serialize the whole game into the snapshot buffer.
+//
+void GameSnapshot::save(const ofApp &app) {
+	const Emitter *emitters[SNAPSHOT_EMITTERS] = { app.turret, app.enemy, app.enemyT };
+	const vector<Particle> &particles = app.explosion.sys->particles;
+	float time = ofGetElapsedTimeMillis();
+	double simTime = GameClock::isFixed() ? 0 : GameClock::millis();
+
+	// size the buffer up front so everything below is a straight copy
+	//
+	size_t total = sizeof(SnapshotHeader) + SNAPSHOT_EMITTERS * sizeof(EmitterRecord);
+	for (int i = 0; i < SNAPSHOT_EMITTERS; i++)
+		total += emitters[i]->sys->sprites.size() * sizeof(SpriteRecord);
+	total += particles.size() * sizeof(Particle);
+	data.resize(total);
+
+	char *p = data.data();
+
+	SnapshotHeader *header = (SnapshotHeader *)p;
+	header->magic = SNAPSHOT_MAGIC;
+	header->version = SNAPSHOT_VERSION;
+	header->particleSize = sizeof(Particle);
+	header->score = app.score;
+	header->gameState = stateToInt(app.game_state);
+	header->numEmitters = SNAPSHOT_EMITTERS;
+	for (int i = 0; i < SNAPSHOT_EMITTERS; i++)
+		header->numSprites[i] = emitters[i]->sys->sprites.size();
+	header->numParticles = particles.size();
+	header->saveTime = time;
+	header->tick = GameClock::tick();
+	writeVec(header->explosionPos, app.explosion.position);
+	header->explosionStarted = app.explosion.started;
+	header->explosionFired = app.explosion.fired;
+	header->gameOver = app.gameOver;
+	header->pad = 0;
+	p += sizeof(SnapshotHeader);
+
+	for (int i = 0; i < SNAPSHOT_EMITTERS; i++) {
+		const Emitter *e = emitters[i];
+		EmitterRecord *r = (EmitterRecord *)p;
+		writeVec(r->trans, e->trans);
+		r->rotation = e->rotation;
+		writeVec(r->vel, e->vel);
+		writeVec(r->force, e->force);
+		writeVec(r->acceleration, e->acceleration);
+		writeVec(r->velocity, e->velocity);
+		r->angularVelocity = e->angularVelocity;
+		r->angularAcceleration = e->angularAcceleration;
+		r->angularForce = e->angularForce;
+		r->lifespan = e->lifespan;
+		r->health = app.health.get(e->healthSlot);
+		r->rate = e->rate;
+		r->lastSpawnedAge = simTime - e->lastSpawned;
+		writeVec(r->head, e->head);
+		writeVec(r->left, e->left);
+		r->body = e->body;
+		r->started = e->started;
+		r->drawable = e->drawable;
+		r->pad[0] = r->pad[1] = 0;
+		p += sizeof(EmitterRecord);
+	}
+
+	for (int i = 0; i < SNAPSHOT_EMITTERS; i++) {
+		const vector<Sprite> &sprites = emitters[i]->sys->sprites;
+		for (int j = 0; j < sprites.size(); j++) {
+			const Sprite &s = sprites[j];
+			SpriteRecord *r = (SpriteRecord *)p;
+			writeVec(r->trans, s.trans);
+			r->rotation = s.rotation;
+			writeVec(r->velocity, s.velocity);
+			r->age = simTime - s.birthtime;
+			r->lifespan = s.lifespan;
+			r->width = s.width;
+			r->height = s.height;
+			r->path = s.path;
+			r->path.spawnTime = simTime - s.path.spawnTime;
+			p += sizeof(SpriteRecord);
+		}
+	}
+
+	// particles go in as one block; birthtimes are rebased on restore
+	//
+	if (!particles.empty())
+		memcpy(p, particles.data(), particles.size() * sizeof(Particle));
+}
+
+//  Restore the game from the snapshot buffer. Sprite vectors are resized in
+//  place so sprites that already exist keep their image.
+//
+bool GameSnapshot::restore(ofApp &app) const {
+	if (data.size() < sizeof(SnapshotHeader)) return false;
+
+	const char *p = data.data();
+	const SnapshotHeader *header = (const SnapshotHeader *)p;
+	if (header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION) {
+		cout << "snapshot: bad magic or unsupported version" << endl;
+		return false;
+	}
+	if (header->particleSize != sizeof(Particle) || header->numEmitters != SNAPSHOT_EMITTERS) {
+		cout << "snapshot: layout mismatch" << endl;
+		return false;
+	}
+
+	size_t expected = sizeof(SnapshotHeader) + SNAPSHOT_EMITTERS * sizeof(EmitterRecord);
+	for (int i = 0; i < SNAPSHOT_EMITTERS; i++)
+		expected += header->numSprites[i] * sizeof(SpriteRecord);
+	expected += header->numParticles * sizeof(Particle);
+	if (data.size() != expected) {
+		cout << "snapshot: truncated buffer" << endl;
+		return false;
+	}
+
+	float time = ofGetElapsedTimeMillis();
+	if (GameClock::isFixed()) GameClock::setTick(header->tick);
+	double simTime = GameClock::isFixed() ? 0 : GameClock::millis();
+	Emitter *emitters[SNAPSHOT_EMITTERS] = { app.turret, app.enemy, app.enemyT };
+	ofImage *images[SNAPSHOT_EMITTERS] = { &app.bulletImage, &app.targetImage, &app.targetImage };
+
+	app.score = header->score;
+	app.game_state = intToState(header->gameState);
+	app.gameOver = header->gameOver;
+	app.explosion.position = readVec(header->explosionPos);
+	app.explosion.started = header->explosionStarted;
+	app.explosion.fired = header->explosionFired;
+	p += sizeof(SnapshotHeader);
+
+	for (int i = 0; i < SNAPSHOT_EMITTERS; i++) {
+		Emitter *e = emitters[i];
+		const EmitterRecord *r = (const EmitterRecord *)p;
+		e->trans = readVec(r->trans);
+		e->rotation = r->rotation;
+		e->vel = readVec(r->vel);
+		e->force = readVec(r->force);
+		e->acceleration = readVec(r->acceleration);
+		e->velocity = readVec(r->velocity);
+		e->angularVelocity = r->angularVelocity;
+		e->angularAcceleration = r->angularAcceleration;
+		e->angularForce = r->angularForce;
+		e->lifespan = r->lifespan;
+		app.health.set(e->healthSlot, r->health);
+		e->rate = r->rate;
+		e->lastSpawned = simTime - r->lastSpawnedAge;
+		e->head = readVec(r->head);
+		e->left = readVec(r->left);
+		e->body = r->body;
+		e->started = r->started;
+		e->drawable = r->drawable;
+		p += sizeof(EmitterRecord);
+	}
+
+	for (int i = 0; i < SNAPSHOT_EMITTERS; i++) {
+		vector<Sprite> &sprites = emitters[i]->sys->sprites;
+		sprites.resize(header->numSprites[i]);
+		emitters[i]->sys->alive.clear();
+		for (int j = 0; j < sprites.size(); j++) {
+			Sprite &s = sprites[j];
+			const SpriteRecord *r = (const SpriteRecord *)p;
+			if (!s.haveImage) s.setImage(*images[i]);
+			s.trans = readVec(r->trans);
+			s.rotation = r->rotation;
+			s.velocity = readVec(r->velocity);
+			s.birthtime = simTime - r->age;
+			s.lifespan = r->lifespan;
+			s.width = r->width;
+			s.height = r->height;
+			s.path = r->path;
+			s.path.spawnTime = simTime - r->path.spawnTime;
+			p += sizeof(SpriteRecord);
+		}
+	}
+
+	vector<Particle> &particles = app.explosion.sys->particles;
+	const Particle *src = (const Particle *)p;
+	particles.assign(src, src + header->numParticles);
+	app.explosion.sys->invalidateIndex();
+	float shift = time - header->saveTime;
+	for (int i = 0; i < particles.size(); i++)
+		particles[i].birthtime += shift;
+
+	return true;
+}
+
+bool GameSnapshot::saveToFile(const string &path) const {
+	ofBuffer buffer(data.data(), data.size());
+	return ofBufferToFile(path, buffer, true);
+}
+
+bool GameSnapshot::loadFromFile(const string &path) {
+	ofBuffer buffer = ofBufferFromFile(path, true);
+	if (buffer.size() < sizeof(SnapshotHeader)) return false;
+	data.assign(buffer.getData(), buffer.getData() + buffer.size());
+	return true;
+}
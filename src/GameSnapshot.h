@@ -0,0 +1,94 @@
+#pragma once
+#include "ofMain.h"
+#include "Trajectory.h"
+#include "FixedPoint.h"
+
+class ofApp;
+class Emitter;
+class SpriteSystem;
+class ParticleEmitter;
+
+//  Binary snapshot of the full game state (score, emitters, sprites and
+//  explosion particles). The buffer is laid out as:
+//
+//     SnapshotHeader
+//     EmitterRecord   x numEmitters   (turret, enemy, enemyT)
+//     SpriteRecord    x numSprites[i] (one run per emitter sprite system)
+//     Particle        x numParticles  (raw copy of the particle array)
+//
+//  All times are stored as ages relative to the moment of the save so a
+//  snapshot can be restored at any later time. Sprite and emitter ages are
+//  on the GameClock, particles (cosmetic) on the wall clock. With a fixed
+//  step clock the snapshot instead keeps the tick and absolute times
+//  (stored as 0 - time), and restoring rewinds the clock to that tick, so a
+//  restored state is bit identical to the saved one. The buffer is kept between
+//  saves so repeated snapshots do not allocate.
+//
+#define SNAPSHOT_MAGIC    0x50534741   // "AGSP"
+#define SNAPSHOT_VERSION  4
+#define SNAPSHOT_EMITTERS 3
+
+struct SnapshotHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t particleSize;   // sizeof(Particle) when the snapshot was written
+	int32_t  score;
+	int32_t  gameState;      // see GameSnapshot::stateToInt()
+	uint32_t numEmitters;
+	uint32_t numSprites[SNAPSHOT_EMITTERS];
+	uint32_t numParticles;
+	float    saveTime;       // ms, particle birthtimes are shifted by (now - saveTime)
+	uint32_t tick;           // GameClock tick, fixed step clock only
+	float    explosionPos[3];
+	uint8_t  explosionStarted;
+	uint8_t  explosionFired;
+	uint8_t  gameOver;
+	uint8_t  pad;
+};
+
+struct EmitterRecord {
+	float    trans[3];
+	float    rotation;
+	float    vel[3];
+	float    force[3];
+	float    acceleration[3];
+	float    velocity[3];
+	float    angularVelocity;
+	float    angularAcceleration;
+	float    angularForce;
+	float    lifespan;        // ms, given to spawned sprites
+	float    health;          // ofApp::health of the emitter
+	float    rate;
+	float    lastSpawnedAge;  // ms since last spawn
+	float    head[3];
+	float    left[3];
+	FixedBody body;           // deterministic mode physics state
+	uint8_t  started;
+	uint8_t  drawable;
+	uint8_t  pad[2];
+};
+
+struct SpriteRecord {
+	float    trans[3];
+	float    rotation;
+	float    velocity[3];
+	float    age;             // ms
+	float    lifespan;        // ms
+	float    width, height;
+	Trajectory path;          // path.spawnTime is stored as an age (ms)
+};
+
+class GameSnapshot {
+public:
+	void save(const ofApp &app);
+	bool restore(ofApp &app) const;
+	bool saveToFile(const string &path) const;
+	bool loadFromFile(const string &path);
+	bool isEmpty() const { return data.empty(); }
+	size_t size() const { return data.size(); }
+
+	static int stateToInt(const string &state);
+	static string intToState(int state);
+
+	vector<char> data;
+};
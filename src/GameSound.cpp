@@ -0,0 +1,62 @@
+#include "GameSound.h"
+#include "MemoryTracker.h"
+
+static bool nullDevice = false;
+static bool deferred = false;
+static bool muted = false;
+
+void GameSound::setNullDevice(bool null) {
+	nullDevice = null;
+}
+
+bool GameSound::isNullDevice() {
+	return nullDevice;
+}
+
+void GameSound::setDeferred(bool d) {
+	deferred = d;
+}
+
+void GameSound::setMuted(bool m) {
+	muted = m;
+}
+
+GameSound::GameSound() {
+	kind = SoundEffect;
+	loaded = false;
+	pending.store(false);
+}
+
+bool GameSound::load(const string &path, SoundKind k) {
+	MemoryScope scope(MemAudio);
+	kind = k;
+	if (nullDevice) return true;
+	loaded = player.load(path, kind == SoundMusic);
+	if (!loaded) cout << "can't load sound: " << path << endl;
+	return loaded;
+}
+
+void GameSound::play() {
+	if (!loaded || muted) return;
+	MemoryScope scope(MemAudio);
+	if (deferred) pending.store(true);
+	else player.play();
+}
+
+void GameSound::service() {
+	if (!pending.exchange(false)) return;
+	MemoryScope scope(MemAudio);
+	player.play();
+}
+
+void GameSound::stop() {
+	if (loaded) player.stop();
+}
+
+bool GameSound::isPlaying() {
+	return loaded && player.isPlaying();
+}
+
+void GameSound::setLoop(bool loop) {
+	if (loaded) player.setLoop(loop);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "ofMain.h"
+#include <atomic>
+
+//  ofSoundPlayer wrapper that separates music from sound effects. Music is
+//  opened streaming: the sound backend decodes it a block at a time into a
+//  small buffer on its own stream thread instead of decoding the whole
+//  track into memory at load. Short effects are loaded fully so they can
+//  be retriggered without latency.
+//
+//  In deferred mode play() only marks the sound as requested and service()
+//  starts it; this lets a simulation thread trigger sounds while all calls
+//  into the sound backend stay on the main thread.
+//
+//  While muted, play() is ignored; lockstep rollback uses this so replayed
+//  ticks do not trigger their sounds a second time.
+//
+//  With the null device selected (headless and software rendering runs)
+//  nothing is loaded or played, so no audio hardware is needed.
+//
+enum SoundKind { SoundEffect, SoundMusic };
+
+class GameSound {
+public:
+	GameSound();
+	bool load(const string &path, SoundKind kind);
+	void play();
+	void stop();
+	bool isPlaying();
+	void setLoop(bool loop);
+	void service();
+
+	static void setNullDevice(bool null);
+	static bool isNullDevice();
+	static void setDeferred(bool deferred);
+	static void setMuted(bool muted);      // play() does nothing, e.g. while replaying ticks
+
+	SoundKind kind;
+private:
+	ofSoundPlayer player;
+	bool loaded;
+	std::atomic<bool> pending;
+};
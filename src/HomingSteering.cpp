@@ -0,0 +1,81 @@
+#include "HomingSteering.h"
+#include "ofApp.h"
+
+HomingSteering::HomingSteering() {
+	turnRate = PI / 2;
+	searchRadius = 2000;
+}
+
+void HomingSteering::setTargets(const vector<glm::vec3> &targets) {
+	targetX.resize(targets.size());
+	targetY.resize(targets.size());
+	for (int i = 0; i < targets.size(); i++) {
+		targetX[i] = targets[i].x;
+		targetY[i] = targets[i].y;
+	}
+	grid.build(targetX.data(), targetY.data(), targets.size(), 128);
+}
+
+//  The gathered arrays are tick scratch taken from arena
+//
+void HomingSteering::steer(SpriteSystem &sys, float dt, FrameArena &arena) {
+	vector<Sprite> &sprites = sys.sprites;
+
+	// gather the homing sprites
+	//
+	FrameVector<int> index(arena);
+	index.reserve(sprites.size());
+	for (int i = 0; i < sprites.size(); i++) {
+		if (sprites[i].path.pattern == TrajHoming) index.push_back(i);
+	}
+	int n = index.size();
+	if (n == 0) return;
+	float *px = arena.allocArray<float>(n);
+	float *py = arena.allocArray<float>(n);
+	float *vx = arena.allocArray<float>(n);
+	float *vy = arena.allocArray<float>(n);
+	float *tx = arena.allocArray<float>(n);
+	float *ty = arena.allocArray<float>(n);
+	for (int k = 0; k < n; k++) {
+		const Sprite &s = sprites[index[k]];
+		px[k] = s.trans.x;
+		py[k] = s.trans.y;
+		vx[k] = s.velocity.x;
+		vy[k] = s.velocity.y;
+	}
+
+	// nearest target for each projectile; with nothing in range aim
+	// straight ahead so the kernel leaves the heading alone
+	//
+	for (int k = 0; k < n; k++) {
+		int t = grid.nearest(px[k], py[k], searchRadius);
+		tx[k] = (t >= 0) ? targetX[t] : px[k] + vx[k];
+		ty[k] = (t >= 0) ? targetY[t] : py[k] + vy[k];
+	}
+
+	// rotate each velocity toward its target by at most maxTurn and move
+	//
+	float maxTurn = turnRate * dt;
+	for (int k = 0; k < n; k++) {
+		float speed = sqrtf(vx[k] * vx[k] + vy[k] * vy[k]);
+		float ex = tx[k] - px[k];
+		float ey = ty[k] - py[k];
+		float cross = vx[k] * ey - vy[k] * ex;
+		float dot = vx[k] * ex + vy[k] * ey;
+		float angle = ofClamp(atan2f(cross, dot), -maxTurn, maxTurn);
+		float c = cosf(angle);
+		float s = sinf(angle);
+		float nx = vx[k] * c - vy[k] * s;
+		float ny = vx[k] * s + vy[k] * c;
+		vx[k] = (speed > 0) ? nx : 0;
+		vy[k] = (speed > 0) ? ny : 0;
+		px[k] += vx[k] * dt;
+		py[k] += vy[k] * dt;
+	}
+
+	for (int k = 0; k < n; k++) {
+		Sprite &s = sprites[index[k]];
+		s.trans = glm::vec3(px[k], py[k], 0);
+		s.velocity = ofVec3f(vx[k], vy[k], 0);
+	}
+}
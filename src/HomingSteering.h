@@ -0,0 +1,27 @@
+#pragma once
+#include "ofMain.h"
+#include "SpatialGrid.h"
+#include "FrameArena.h"
+
+class SpriteSystem;
+
+//  Steers every TrajHoming sprite of a sprite system toward its nearest
+//  target, turning at most turnRate radians/sec. Targets are kept in a
+//  SpatialGrid; projectiles are gathered into flat arrays, steered in one
+//  pass and written back, so the cost per tick is linear in the number of
+//  homing projectiles. The flat arrays come from the caller's FrameArena.
+//
+//  A homing sprite's velocity is its actual velocity in pixels/sec.
+//
+class HomingSteering {
+public:
+	HomingSteering();
+	void setTargets(const vector<glm::vec3> &targets);
+	void steer(SpriteSystem &sys, float dt, FrameArena &arena);
+
+	float turnRate;       // radians/sec
+	float searchRadius;   // pixels, projectiles with no target in range fly straight
+	SpatialGrid grid;
+private:
+	vector<float> targetX, targetY;
+};
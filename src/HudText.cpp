@@ -0,0 +1,73 @@
+#include "HudText.h"
+#include "RenderBackend.h"
+#include "MemoryTracker.h"
+
+HudText::HudText() {
+	font = NULL;
+	value = 0;
+	haveValue = false;
+	dirty = true;
+	width = 0;
+	height = 0;
+	rebuilds = 0;
+}
+
+//  prefix is put in front of the value passed to setValue()
+//
+void HudText::setup(const ofTrueTypeFont *f, const string &p) {
+	MemoryScope scope(MemUI);
+	font = f;
+	prefix = p;
+	text.reserve(prefix.size() + 16);
+	text = prefix;
+	dirty = true;
+}
+
+void HudText::setValue(int v) {
+	if (haveValue && v == value) return;
+	value = v;
+	haveValue = true;
+
+	// format into the reserved string so no allocation happens here
+	//
+	char digits[16];
+	snprintf(digits, sizeof(digits), "%d", v);
+	text.assign(prefix);
+	text.append(digits);
+	dirty = true;
+}
+
+void HudText::setText(const string &t) {
+	if (t == text) return;
+	MemoryScope scope(MemUI);
+	text = t;
+	dirty = true;
+}
+
+void HudText::rebuild() {
+	MemoryScope scope(MemUI);
+	RenderBackend *render = RenderBackend::get();
+	if (!render->isSoftware()) mesh = font->getStringMesh(text, 0, 0);
+	width = render->stringWidth(*font, text);
+	height = render->stringHeight(*font, text);
+	dirty = false;
+	rebuilds++;
+}
+
+float HudText::getWidth() {
+	if (dirty && font != NULL) rebuild();
+	return width;
+}
+
+float HudText::getHeight() {
+	if (dirty && font != NULL) rebuild();
+	return height;
+}
+
+//  Draw with the left end of the baseline at (x, y)
+//
+void HudText::draw(float x, float y) {
+	if (font == NULL) return;
+	if (dirty) rebuild();
+	RenderBackend::get()->drawTextMesh(*font, mesh, text, x, y);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "ofMain.h"
+
+//  A HUD string drawn from a cached glyph mesh. ofTrueTypeFont already
+//  rasterizes its glyphs into one atlas texture when it is loaded; HudText
+//  keeps the quads for its string in a VBO mesh along with the string's
+//  width and height, and only rebuilds them when the text changes. Drawing
+//  an unchanged string does no layout and no allocation.
+//
+class HudText {
+public:
+	HudText();
+	void setup(const ofTrueTypeFont *font, const string &prefix);
+	void setValue(int value);
+	void setText(const string &text);
+	void draw(float x, float y);
+	float getWidth();
+	float getHeight();
+
+	int rebuilds;     // number of times the mesh has been rebuilt
+private:
+	void rebuild();
+	const ofTrueTypeFont *font;
+	string prefix;
+	string text;
+	int value;
+	bool haveValue;
+	bool dirty;
+	ofVboMesh mesh;
+	float width, height;
+};
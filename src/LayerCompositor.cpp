@@ -0,0 +1,43 @@
+#include "LayerCompositor.h"
+#include "MemoryTracker.h"
+
+LayerCompositor::LayerCompositor() {
+	width = 0;
+	height = 0;
+	rebuilds = 0;
+}
+
+int LayerCompositor::addStaticLayer(const ofImage *image) {
+	StaticLayer layer;
+	layer.image = image;
+	layer.width = 0;
+	layer.height = 0;
+	layers.push_back(layer);
+	return layers.size() - 1;
+}
+
+//  Rebuild the layer caches for a new window size
+//
+void LayerCompositor::resize(int w, int h) {
+	MemoryScope scope(MemAssets);
+	width = w;
+	height = h;
+	RenderBackend *render = RenderBackend::get();
+	for (int i = 0; i < layers.size(); i++) {
+		render->prepareLayer(layers[i], w, h);
+		rebuilds++;
+	}
+}
+
+void LayerCompositor::drawStatic(int layer) {
+	if (layer < 0 || layer >= layers.size()) return;
+	StaticLayer &l = layers[layer];
+
+	// the backend may have changed since the cache was built
+	//
+	if (l.width != width || l.height != height) {
+		RenderBackend::get()->prepareLayer(l, width, height);
+		rebuilds++;
+	}
+	RenderBackend::get()->drawLayer(l);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "RenderBackend.h"
+
+//  Splits the frame into static layers (full window images that never
+//  change, like the background) and everything drawn on top of them.
+//  Static layers are scaled to the window once, when they are added and
+//  whenever the window is resized, instead of being resampled every frame.
+//
+//  Add all layers before the first resize(); layer handles are indices.
+//
+class LayerCompositor {
+public:
+	LayerCompositor();
+	int addStaticLayer(const ofImage *image);
+	void resize(int w, int h);
+	void drawStatic(int layer);
+
+	int rebuilds;     // number of times a layer cache has been rebuilt
+private:
+	vector<StaticLayer> layers;
+	int width, height;
+};
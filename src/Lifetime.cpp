@@ -0,0 +1,61 @@
+#include "Lifetime.h"
+
+void AliveSet::kill(int i) {
+	int word = i >> 6;
+	uint64_t bit = 1ULL << (i & 63);
+	if (word >= bits.size()) bits.resize(word + 1, 0);
+	if (bits[word] & bit) return;
+	bits[word] |= bit;
+	deadCount++;
+}
+
+bool AliveSet::isAlive(int i) const {
+	int word = i >> 6;
+	return word >= bits.size() || !(bits[word] & (1ULL << (i & 63)));
+}
+
+//  Index of the first dead entity below n, or n. Whole words of living
+//  entities are skipped at once.
+//
+int AliveSet::firstDead(int n) const {
+	for (int w = 0; w < bits.size(); w++) {
+		if (!bits[w]) continue;
+		int i = w * 64;
+		while (!(bits[w] & (1ULL << (i & 63)))) i++;
+		return MIN(i, n);
+	}
+	return n;
+}
+
+void AliveSet::clear() {
+	std::fill(bits.begin(), bits.end(), 0);
+	deadCount = 0;
+}
+
+//  Add an entity with this much health and return its slot
+//
+int HealthPool::add(float health) {
+	hp.push_back(health);
+	pending.push_back(0);
+	return hp.size() - 1;
+}
+
+//  Subtract the queued damage. Returns how many were alive before and are
+//  not any more.
+//
+int HealthPool::apply() {
+	int died = 0;
+	for (int i = 0; i < hp.size(); i++) {
+		if (pending[i] == 0) continue;
+		bool wasAlive = hp[i] > 0;
+		hp[i] -= pending[i];
+		pending[i] = 0;
+		if (wasAlive && hp[i] <= 0) died++;
+	}
+	return died;
+}
+
+void HealthPool::clear() {
+	hp.clear();
+	pending.clear();
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "ofMain.h"
+
+//  Lifetime components, kept out of the objects in dense arrays:
+//
+//     AliveSet    one bit per entity of an array; kill() marks an entity
+//                 wherever the game finds out it is gone, and reap() then
+//                 removes all dead entities from the array in one pass
+//     HealthPool  hit points; damage() queues where a hit is found and
+//                 apply() subtracts everything queued in one pass
+//
+//  A sprite's time to live stays Sprite::lifespan (ms); SpriteSystem
+//  kills expired sprites and reaps them with the ones shot down.
+//
+class AliveSet {
+public:
+	AliveSet() : deadCount(0) {}
+	void kill(int i);
+	bool isAlive(int i) const;
+	int dead() const { return deadCount; }
+	void clear();
+	template<class T> int reap(vector<T> &items);
+private:
+	int firstDead(int n) const;
+	vector<uint64_t> bits;   // set => dead, so entities are alive without being added
+	int deadCount;
+};
+
+//  Remove the dead entities from items, keeping the order of the others,
+//  and start over with everything alive. Returns the number removed.
+//
+template<class T> int AliveSet::reap(vector<T> &items) {
+	if (deadCount == 0) return 0;
+	int n = items.size();
+	int out = firstDead(n);
+	for (int i = out + 1; i < n; i++) {
+		if (!isAlive(i)) continue;
+		items[out++] = std::move(items[i]);
+	}
+	int removed = n - MIN(out, n);
+	items.erase(items.begin() + MIN(out, n), items.end());
+	clear();
+	return removed;
+}
+
+class HealthPool {
+public:
+	int add(float health);
+	void set(int slot, float health) { hp[slot] = health; }
+	float get(int slot) const { return hp[slot]; }
+	bool isAlive(int slot) const { return hp[slot] > 0; }
+	void damage(int slot, float amount) { pending[slot] += amount; }
+	int apply();
+	void clear();
+
+	vector<float> hp;
+	vector<float> pending;   // damage queued since the last apply()
+};
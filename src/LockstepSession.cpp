@@ -0,0 +1,261 @@
+#include "LockstepSession.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+LockstepSession::LockstepSession() {
+	sock = -1;
+	player = 0;
+	loss = 0;
+	delay = 0;
+	rollbackTick = 0;
+	packetsSent = packetsDropped = packetsReceived = bytesSent = 0;
+	rollbacks = desyncs = 0;
+	memset(peerAddr, 0, sizeof(peerAddr));
+	memset(inputs, 0, sizeof(inputs));
+	memset(predicted, 0, sizeof(predicted));
+	memset(predictedTick, 0, sizeof(predictedTick));
+	localNext = remoteNext = peerAck = 1;
+	peerCheckTick = 0;
+	peerChecksum = 0;
+	random = 2463534242u;
+}
+
+LockstepSession::~LockstepSession() {
+	close();
+}
+
+//  Listen on port and exchange inputs with peer ("host:port"). Ticks start
+//  at 1 on both sides.
+//
+bool LockstepSession::setup(int p, int port, const string &peer) {
+	close();
+	player = p;
+
+	size_t colon = peer.rfind(':');
+	if (colon == string::npos) {
+		cout << "lockstep: peer must be host:port, got " << peer << endl;
+		return false;
+	}
+	string host = peer.substr(0, colon);
+	string service = peer.substr(colon + 1);
+
+#ifdef _WIN32
+	static bool started = false;
+	if (!started) {
+		WSADATA wsa;
+		if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+		started = true;
+	}
+#endif
+
+	struct addrinfo hints, *found = NULL;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	if (getaddrinfo(host.c_str(), service.c_str(), &hints, &found) != 0 || found == NULL) {
+		cout << "lockstep: can't resolve " << peer << endl;
+		return false;
+	}
+	memcpy(peerAddr, found->ai_addr, sizeof(sockaddr_in));
+	freeaddrinfo(found);
+
+	intptr_t s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (s == -1) {
+		cout << "lockstep: can't create socket" << endl;
+		return false;
+	}
+	sockaddr_in local;
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(port);
+	bool ok = bind(s, (sockaddr *)&local, sizeof(local)) == 0;
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	ok = ok && ioctlsocket(s, FIONBIO, &nonBlocking) == 0;
+#else
+	ok = ok && fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK) == 0;
+#endif
+	if (!ok) {
+		cout << "lockstep: can't bind udp port " << port << endl;
+#ifdef _WIN32
+		closesocket(s);
+#else
+		::close(s);
+#endif
+		return false;
+	}
+	sock = s;
+	return true;
+}
+
+void LockstepSession::close() {
+	if (sock == -1) return;
+#ifdef _WIN32
+	closesocket(sock);
+#else
+	::close(sock);
+#endif
+	sock = -1;
+	outgoing.clear();
+}
+
+void LockstepSession::setLocalInput(uint32_t tick, uint8_t input) {
+	inputs[player][tick % LOCKSTEP_WINDOW] = input;
+	localNext = tick + 1;
+}
+
+//  Input of player for tick. Peer inputs that have not arrived are
+//  predicted from the last one that did (without its start press), and
+//  the guess is remembered so a wrong one can be detected.
+//
+uint8_t LockstepSession::input(int p, uint32_t tick) {
+	int slot = tick % LOCKSTEP_WINDOW;
+	if (p == player || (int32_t)(tick - remoteNext) < 0) return inputs[p][slot];
+
+	uint8_t guess = 0;
+	if (remoteNext > 1) guess = inputs[p][(remoteNext - 1) % LOCKSTEP_WINDOW] & ~INPUT_START;
+	predicted[slot] = guess;
+	predictedTick[slot] = tick;
+	return guess;
+}
+
+//  tick can be simulated if its prediction can still be corrected and the
+//  peer has not fallen so far behind that our unacknowledged inputs would
+//  overflow the window.
+//
+bool LockstepSession::canAdvance(uint32_t tick) const {
+	return (int32_t)(tick - remoteNext) < LOCKSTEP_WINDOW - 1 && (int32_t)(tick - peerAck) < LOCKSTEP_WINDOW;
+}
+
+void LockstepSession::transmit(const vector<char> &data) {
+	sendto(sock, data.data(), data.size(), 0, (sockaddr *)peerAddr, sizeof(sockaddr_in));
+	packetsSent++;
+	bytesSent += data.size();
+}
+
+//  Send every input the peer has not acknowledged, our ack and a checksum
+//
+void LockstepSession::send(float now, uint32_t checkTick, uint64_t checksum) {
+	if (sock == -1) return;
+
+	LockstepPacket header;
+	header.magic = LOCKSTEP_MAGIC;
+	header.player = player;
+	header.numRuns = 0;
+	header.firstTick = peerAck;
+	header.ack = remoteNext;
+	header.checkTick = checkTick;
+	header.checksum = checksum;
+
+	packet.resize(sizeof(header));
+	for (uint32_t tick = peerAck; tick != localNext; tick++) {
+		uint8_t value = inputs[player][tick % LOCKSTEP_WINDOW];
+		size_t n = packet.size();
+		if (header.numRuns > 0 && (uint8_t)packet[n - 1] == value) {
+			packet[n - 2]++;
+			continue;
+		}
+		packet.push_back(1);
+		packet.push_back(value);
+		header.numRuns++;
+	}
+	memcpy(packet.data(), &header, sizeof(header));
+
+	random ^= random << 13;
+	random ^= random >> 17;
+	random ^= random << 5;
+	if (loss > 0 && random / 4294967296.0 < loss) {
+		packetsDropped++;
+		return;
+	}
+	if (delay > 0) {
+		DelayedPacket d;
+		d.due = now + delay;
+		d.data = packet;
+		outgoing.push_back(d);
+	}
+	else transmit(packet);
+}
+
+//  Send delayed packets that are due and read everything that has arrived
+//
+void LockstepSession::poll(float now) {
+	if (sock == -1) return;
+
+	int sent = 0;
+	while (sent < outgoing.size() && outgoing[sent].due <= now)
+		transmit(outgoing[sent++].data);
+	outgoing.erase(outgoing.begin(), outgoing.begin() + sent);
+
+	char buffer[512];
+	for (;;) {
+		int size = recvfrom(sock, buffer, sizeof(buffer), 0, NULL, NULL);
+		if (size < 0) break;
+		receive(buffer, size);
+	}
+}
+
+//  Runs are applied from remoteNext on; inputs we already have (resends)
+//  are skipped. Inputs too far ahead of our own ticks are dropped so their
+//  slots stay free, and the peer resends them once we ack.
+//
+void LockstepSession::receive(const char *data, int size) {
+	LockstepPacket header;
+	if (size < (int)sizeof(header)) return;
+	memcpy(&header, data, sizeof(header));
+	if (header.magic != LOCKSTEP_MAGIC || header.player != 1 - player) return;
+	if (size != sizeof(header) + 2 * header.numRuns) return;
+	packetsReceived++;
+
+	if ((int32_t)(header.ack - peerAck) > 0 && (int32_t)(header.ack - localNext) <= 0)
+		peerAck = header.ack;
+	if (header.checkTick != 0 && (int32_t)(header.checkTick - peerCheckTick) > 0) {
+		peerCheckTick = header.checkTick;
+		peerChecksum = header.checksum;
+	}
+
+	int remote = 1 - player;
+	const uint8_t *runs = (const uint8_t *)(data + sizeof(header));
+	uint32_t tick = header.firstTick;
+	for (int r = 0; r < header.numRuns; r++) {
+		for (int k = 0; k < runs[2 * r]; k++, tick++) {
+			if (tick != remoteNext) continue;
+			if ((int32_t)(tick - localNext) >= LOCKSTEP_WINDOW - 1) return;
+			int slot = tick % LOCKSTEP_WINDOW;
+			uint8_t value = runs[2 * r + 1];
+			inputs[remote][slot] = value;
+			if (predictedTick[slot] == tick) {
+				if (predicted[slot] != value && (rollbackTick == 0 || (int32_t)(tick - rollbackTick) < 0))
+					rollbackTick = tick;
+				predictedTick[slot] = 0;
+			}
+			remoteNext++;
+		}
+	}
+}
+
+//  Compare the peer's last checksum with ours once we have simulated that
+//  tick with confirmed inputs. Call after any rollback has been replayed.
+//
+void LockstepSession::verify(uint32_t simulatedTick, const StateChecksum &checksums) {
+	if (peerCheckTick == 0) return;
+	if ((int32_t)(peerCheckTick - remoteNext) >= 0 || (int32_t)(peerCheckTick - simulatedTick) > 0) return;
+	uint64_t sum;
+	if (checksums.lookup(peerCheckTick, sum) && sum != peerChecksum) {
+		desyncs++;
+		cout << "lockstep: desync at tick " << peerCheckTick << endl;
+	}
+	peerCheckTick = 0;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "ofMain.h"
+#include "StateChecksum.h"
+
+//  Two player lockstep over UDP. Both processes run the same deterministic
+//  simulation (see GameClock) and the only thing exchanged is each player's
+//  input for every tick: one byte of INPUT_* bits.
+//
+//  Ticks are never held back waiting for the peer. A missing input is
+//  predicted (the peer's last known input repeated), and when the real one
+//  arrives and differs, rollbackTick tells the game to go back to the state
+//  before that tick and simulate forward again. The game may run at most
+//  LOCKSTEP_WINDOW - 1 ticks past the last input it has from the peer.
+//
+//  Every packet repeats all local inputs the peer has not acknowledged yet,
+//  run length encoded, so a lost packet only costs latency and a held key
+//  is two bytes however long it is held:
+//
+//     LockstepPacket        header
+//     numRuns x (count, input)   inputs from firstTick on
+//
+//  Packets also carry the checksum of a tick the sender has simulated with
+//  confirmed inputs; a mismatch with ours is counted as a desync.
+//
+//  Loss and latency can be simulated on the sending side for testing two
+//  processes on one machine.
+//
+#define LOCKSTEP_WINDOW  64
+#define LOCKSTEP_MAGIC   0x4c53
+
+enum InputBits {
+	INPUT_UP = 1,
+	INPUT_DOWN = 2,
+	INPUT_LEFT = 4,
+	INPUT_RIGHT = 8,
+	INPUT_FIRE = 16,
+	INPUT_ROTATE_LEFT = 32,
+	INPUT_ROTATE_RIGHT = 64,
+	INPUT_START = 128,
+};
+
+#pragma pack(push, 1)
+struct LockstepPacket {
+	uint16_t magic;
+	uint8_t  player;      // sender
+	uint8_t  numRuns;
+	uint32_t firstTick;   // tick of the first input in the runs
+	uint32_t ack;         // sender has every input of the receiver before this tick
+	uint32_t checkTick;   // tick the checksum is for, 0 => none
+	uint64_t checksum;
+};
+#pragma pack(pop)
+
+class LockstepSession {
+public:
+	LockstepSession();
+	~LockstepSession();
+	bool setup(int player, int port, const string &peer);
+	void close();
+	bool isActive() const { return sock != -1; }
+
+	void setLocalInput(uint32_t tick, uint8_t input);
+	uint8_t input(int player, uint32_t tick);
+	bool canAdvance(uint32_t tick) const;
+	uint32_t confirmedTick() const { return remoteNext - 1; }
+	void poll(float now);
+	void send(float now, uint32_t checkTick, uint64_t checksum);
+	void verify(uint32_t simulatedTick, const StateChecksum &checksums);
+
+	int player;             // 0 plays the turret, 1 the right enemy
+	float loss;             // fraction of packets dropped when sending
+	float delay;            // ms each packet is held before sending
+	uint32_t rollbackTick;  // earliest mispredicted tick, 0 => none
+	int packetsSent, packetsDropped, packetsReceived, bytesSent;
+	int rollbacks, desyncs;
+private:
+	struct DelayedPacket {
+		float due;
+		vector<char> data;
+	};
+	void receive(const char *data, int size);
+	void transmit(const vector<char> &data);
+	intptr_t sock;               // -1 when closed
+	char peerAddr[16];           // sockaddr_in, opaque so no socket headers here
+	uint8_t inputs[2][LOCKSTEP_WINDOW];
+	uint8_t predicted[LOCKSTEP_WINDOW];      // peer input a tick was simulated with
+	uint32_t predictedTick[LOCKSTEP_WINDOW];
+	uint32_t localNext;          // first tick without a local input
+	uint32_t remoteNext;         // first tick without a peer input
+	uint32_t peerAck;            // peer has our inputs before this tick
+	uint32_t peerCheckTick;      // last checksum the peer sent
+	uint64_t peerChecksum;
+	vector<DelayedPacket> outgoing;
+	vector<char> packet;
+	uint32_t random;             // loss simulation, separate from ofRandom
+};
@@ -0,0 +1,167 @@
+#include "MemoryTracker.h"
+#include <new>
+#include <cstdlib>
+
+//  Every block starts with a header recording its size and tag, so delete
+//  can credit the right tag. 16 bytes keeps the block as aligned as malloc
+//  made it.
+//
+struct MemoryHeader {
+	uint64_t size;
+	uint32_t tag;
+	uint32_t unused;
+};
+#define MEMORY_HEADER 16
+
+//  Zero initialized before any constructor runs, so allocations made
+//  during static initialization are counted too
+//
+struct TagCounters {
+	std::atomic<int64_t> bytes;
+	std::atomic<int64_t> peak;
+	std::atomic<uint64_t> allocations;
+};
+static TagCounters counters[MEMORY_TAGS];
+static thread_local int currentTag = MemUntagged;
+
+static uint64_t frameStart[MEMORY_TAGS];   // allocations when the last frame closed
+static uint64_t frameCount[MEMORY_TAGS];
+
+static const char *tagNames[MEMORY_TAGS] = { "other", "sprites", "particles", "assets", "audio", "ui" };
+
+MemoryScope::MemoryScope(MemoryTag tag) {
+	previous = currentTag;
+	currentTag = tag;
+}
+
+MemoryScope::~MemoryScope() {
+	currentTag = previous;
+}
+
+void *MemoryTracker::allocate(size_t size) {
+	char *block = (char *)malloc(size + MEMORY_HEADER);
+	if (block == NULL) return NULL;
+	MemoryHeader *header = (MemoryHeader *)block;
+	header->size = size;
+	header->tag = currentTag;
+
+	//the peak may miss a concurrent allocation on another thread; good
+	//enough for a high water mark
+	TagCounters &c = counters[currentTag];
+	int64_t now = c.bytes.fetch_add(size, std::memory_order_relaxed) + size;
+	if (now > c.peak.load(std::memory_order_relaxed)) c.peak.store(now, std::memory_order_relaxed);
+	c.allocations.fetch_add(1, std::memory_order_relaxed);
+	return block + MEMORY_HEADER;
+}
+
+void MemoryTracker::release(void *p) {
+	if (p == NULL) return;
+	char *block = (char *)p - MEMORY_HEADER;
+	MemoryHeader *header = (MemoryHeader *)block;
+	counters[header->tag].bytes.fetch_sub(header->size, std::memory_order_relaxed);
+	free(block);
+}
+
+//  Close the current frame; call once per frame from the main thread
+//
+void MemoryTracker::frame() {
+	for (int t = 0; t < MEMORY_TAGS; t++) {
+		uint64_t n = allocations(t);
+		frameCount[t] = n - frameStart[t];
+		frameStart[t] = n;
+	}
+}
+
+int64_t MemoryTracker::current(int tag) {
+	return counters[tag].bytes.load(std::memory_order_relaxed);
+}
+
+int64_t MemoryTracker::peak(int tag) {
+	return counters[tag].peak.load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::allocations(int tag) {
+	return counters[tag].allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t MemoryTracker::frameAllocations(int tag) {
+	return frameCount[tag];
+}
+
+const char *MemoryTracker::name(int tag) {
+	return tagNames[tag];
+}
+
+//  "sprites 1.2/3.0 MB, particles ..." current and peak per tag
+//
+string MemoryTracker::summary() {
+	string s;
+	for (int t = 0; t < MEMORY_TAGS; t++) {
+		if (t > 0) s += ", ";
+		s += string(name(t)) + " " + ofToString(current(t) / 1048576.0, 1) + "/" + ofToString(peak(t) / 1048576.0, 1) + " MB";
+	}
+	return s;
+}
+
+//  Allocations per tag in the last closed frame
+//
+string MemoryTracker::frameSummary() {
+	string s;
+	for (int t = 0; t < MEMORY_TAGS; t++) {
+		if (t > 0) s += ", ";
+		s += string(name(t)) + " " + ofToString(frameCount[t]);
+	}
+	return s;
+}
+
+#ifndef NO_MEMORY_TRACKING
+
+//  The nothrow, array and sized forms all come here as well, so a block is
+//  always freed by the same code that allocated it. Over-aligned new keeps
+//  the library's own implementation.
+//
+void *operator new(size_t size) {
+	void *p = MemoryTracker::allocate(size);
+	if (p == NULL) throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t size) {
+	void *p = MemoryTracker::allocate(size);
+	if (p == NULL) throw std::bad_alloc();
+	return p;
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+	return MemoryTracker::allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+	return MemoryTracker::allocate(size);
+}
+
+void operator delete(void *p) noexcept {
+	MemoryTracker::release(p);
+}
+
+void operator delete[](void *p) noexcept {
+	MemoryTracker::release(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+	MemoryTracker::release(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+	MemoryTracker::release(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+	MemoryTracker::release(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+	MemoryTracker::release(p);
+}
+
+#endif
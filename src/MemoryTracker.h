@@ -0,0 +1,53 @@
+#pragma once
+#include "ofMain.h"
+#include <atomic>
+
+//  Heap accounting by subsystem. The global operator new and delete are
+//  replaced (see MemoryTracker.cpp) and every block is charged to the tag
+//  that was current on the allocating thread, so vector growth, ofPixels
+//  and anything else that goes through new is counted without touching
+//  the containers. Code marks what it allocates for with a MemoryScope:
+//
+//     MemoryScope scope(MemParticles);
+//     particles.push_back(p);
+//
+//  Each tag keeps bytes in use, the high water mark and the number of
+//  allocations; frame() closes a frame so per frame counts can be read.
+//  Memory the sound library or the GL driver allocate themselves with
+//  malloc is not seen.
+//
+//  Build with NO_MEMORY_TRACKING to keep the default operator new; the
+//  counters then stay at zero.
+//
+enum MemoryTag {
+	MemUntagged,
+	MemSprites,
+	MemParticles,
+	MemAssets,
+	MemAudio,
+	MemUI,
+	MEMORY_TAGS
+};
+
+class MemoryScope {
+public:
+	MemoryScope(MemoryTag tag);
+	~MemoryScope();
+private:
+	int previous;
+};
+
+class MemoryTracker {
+public:
+	static void *allocate(size_t size);
+	static void release(void *p);
+	static void frame();
+
+	static int64_t current(int tag);
+	static int64_t peak(int tag);
+	static uint64_t allocations(int tag);        // since startup
+	static uint64_t frameAllocations(int tag);   // in the last closed frame
+	static const char *name(int tag);
+	static string summary();
+	static string frameSummary();
+};
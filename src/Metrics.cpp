@@ -0,0 +1,158 @@
+#include "Metrics.h"
+
+MetricHistogram::MetricHistogram() {
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+		buckets[i].store(0, std::memory_order_relaxed);
+	total.store(0, std::memory_order_relaxed);
+	valueSum.store(0, std::memory_order_relaxed);
+}
+
+//  Values below HISTOGRAM_SUB_BUCKETS get a bucket each; above that the
+//  top HISTOGRAM_SUB_BITS bits below the leading one select the sub bucket
+//  within the value's power of two.
+//
+int MetricHistogram::bucketOf(uint64_t value) {
+	if (value < HISTOGRAM_SUB_BUCKETS) return value;
+	int msb = 63;
+	while (!(value >> msb)) msb--;
+	int shift = msb - HISTOGRAM_SUB_BITS;
+	int bucket = (shift + 1) * HISTOGRAM_SUB_BUCKETS + ((value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1));
+	return MIN(bucket, HISTOGRAM_BUCKETS - 1);
+}
+
+//  Midpoint of the range of values that fall in bucket
+//
+uint64_t MetricHistogram::bucketValue(int bucket) {
+	if (bucket < HISTOGRAM_SUB_BUCKETS) return bucket;
+	int shift = bucket / HISTOGRAM_SUB_BUCKETS - 1;
+	uint64_t low = ((uint64_t)(HISTOGRAM_SUB_BUCKETS + bucket % HISTOGRAM_SUB_BUCKETS)) << shift;
+	return low + ((((uint64_t)1) << shift) >> 1);
+}
+
+void MetricHistogram::record(uint64_t value) {
+	buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+	total.fetch_add(1, std::memory_order_relaxed);
+	valueSum.fetch_add(value, std::memory_order_relaxed);
+}
+
+//  Value below which fraction p (0..1) of the recorded values fall
+//
+uint64_t MetricHistogram::percentile(double p) const {
+	uint64_t n = count();
+	if (n == 0) return 0;
+	uint64_t rank = (uint64_t)ceil(p * n);
+	if (rank == 0) rank = 1;
+	uint64_t seen = 0;
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		seen += buckets[i].load(std::memory_order_relaxed);
+		if (seen >= rank) return bucketValue(i);
+	}
+	return bucketValue(HISTOGRAM_BUCKETS - 1);
+}
+
+MetricsRegistry::MetricsRegistry() {
+	interval = 1000;
+	lastFlush = -FLT_MAX;
+}
+
+MetricsRegistry::~MetricsRegistry() {
+	for (int i = 0; i < entries.size(); i++) {
+		switch (entries[i].type) {
+		case TypeCounter: delete (MetricCounter *)entries[i].metric; break;
+		case TypeGauge: delete (MetricGauge *)entries[i].metric; break;
+		case TypeHistogram: delete (MetricHistogram *)entries[i].metric; break;
+		}
+	}
+}
+
+//  Metrics are allocated individually so the pointers handed out stay
+//  valid as more are registered.
+//
+MetricCounter *MetricsRegistry::counter(const string &name, const string &help) {
+	Entry e = { name, help, TypeCounter, new MetricCounter() };
+	entries.push_back(e);
+	return (MetricCounter *)e.metric;
+}
+
+MetricGauge *MetricsRegistry::gauge(const string &name, const string &help) {
+	Entry e = { name, help, TypeGauge, new MetricGauge() };
+	entries.push_back(e);
+	return (MetricGauge *)e.metric;
+}
+
+MetricHistogram *MetricsRegistry::histogram(const string &name, const string &help) {
+	Entry e = { name, help, TypeHistogram, new MetricHistogram() };
+	entries.push_back(e);
+	return (MetricHistogram *)e.metric;
+}
+
+//  Write the metrics to path every intervalMs. An empty path turns
+//  exporting off.
+//
+void MetricsRegistry::setOutput(const string &path, float intervalMs) {
+	outputPath = path;
+	interval = intervalMs;
+	lastFlush = -FLT_MAX;
+}
+
+void MetricsRegistry::update(float now) {
+	if (outputPath.empty() || now - lastFlush < interval) return;
+	lastFlush = now;
+	flush();
+}
+
+//  Prometheus text format. Histograms are written as summaries with the
+//  usual quantiles since the HDR buckets are too fine to list.
+//
+void MetricsRegistry::format(string &out) const {
+	static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+	char line[256];
+	out.clear();
+	for (int i = 0; i < entries.size(); i++) {
+		const Entry &e = entries[i];
+		const char *type = (e.type == TypeCounter) ? "counter" : (e.type == TypeGauge ? "gauge" : "summary");
+		out += "# HELP " + e.name + " " + e.help + "\n";
+		out += "# TYPE " + e.name + " " + type + "\n";
+		switch (e.type) {
+		case TypeCounter:
+			snprintf(line, sizeof(line), "%s %llu\n", e.name.c_str(), (unsigned long long)((MetricCounter *)e.metric)->get());
+			out += line;
+			break;
+		case TypeGauge:
+			snprintf(line, sizeof(line), "%s %lld\n", e.name.c_str(), (long long)((MetricGauge *)e.metric)->get());
+			out += line;
+			break;
+		case TypeHistogram: {
+			const MetricHistogram *h = (const MetricHistogram *)e.metric;
+			for (int q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+				snprintf(line, sizeof(line), "%s{quantile=\"%g\"} %llu\n", e.name.c_str(), quantiles[q], (unsigned long long)h->percentile(quantiles[q]));
+				out += line;
+			}
+			snprintf(line, sizeof(line), "%s_sum %llu\n%s_count %llu\n", e.name.c_str(), (unsigned long long)h->sum(), e.name.c_str(), (unsigned long long)h->count());
+			out += line;
+			break;
+		}
+		}
+	}
+}
+
+//  Write to a temporary file and rename it over the output so a scraper
+//  never reads a half written file.
+//
+bool MetricsRegistry::flush() {
+	if (outputPath.empty()) return false;
+	format(text);
+	string path = ofToDataPath(outputPath, true);
+	string tmp = path + ".tmp";
+	FILE *f = fopen(tmp.c_str(), "wb");
+	if (f == NULL) return false;
+	bool ok = fwrite(text.data(), 1, text.size(), f) == text.size();
+	ok = (fclose(f) == 0) && ok;
+	if (ok) {
+#ifdef _WIN32
+		remove(path.c_str());   // rename does not replace on Windows
+#endif
+		ok = rename(tmp.c_str(), path.c_str()) == 0;
+	}
+	return ok;
+}
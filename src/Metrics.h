@@ -0,0 +1,88 @@
+#pragma once
+#include "ofMain.h"
+#include <atomic>
+
+//  Lightweight metrics registry. Counters, gauges and histograms are
+//  registered once at startup and updated from the hot path with relaxed
+//  atomics only, so recording costs one uncontended atomic add and any
+//  thread may record. The registry formats everything in the Prometheus
+//  text exposition format and writes it to a file (for a node_exporter
+//  textfile collector) at most once per flush interval; with no output
+//  file set nothing is ever formatted.
+//
+
+//  Monotonic count of events
+//
+class MetricCounter {
+public:
+	MetricCounter() : value(0) {}
+	void add(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+	uint64_t get() const { return value.load(std::memory_order_relaxed); }
+private:
+	std::atomic<uint64_t> value;
+};
+
+//  Current value of something that goes up and down
+//
+class MetricGauge {
+public:
+	MetricGauge() : value(0) {}
+	void set(int64_t v) { value.store(v, std::memory_order_relaxed); }
+	int64_t get() const { return value.load(std::memory_order_relaxed); }
+private:
+	std::atomic<int64_t> value;
+};
+
+//  HDR style histogram of non-negative integer values (microseconds for
+//  times). Each power of two range is split into HISTOGRAM_SUB_BUCKETS
+//  linear buckets, so any recorded value is reported within 2% of its
+//  true value from 1 up to 2^HISTOGRAM_MAX_BITS with a fixed, small
+//  number of buckets.
+//
+#define HISTOGRAM_SUB_BITS    5
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_MAX_BITS    36
+#define HISTOGRAM_BUCKETS     ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+class MetricHistogram {
+public:
+	MetricHistogram();
+	void record(uint64_t value);
+	uint64_t percentile(double p) const;
+	uint64_t count() const { return total.load(std::memory_order_relaxed); }
+	uint64_t sum() const { return valueSum.load(std::memory_order_relaxed); }
+
+	static int bucketOf(uint64_t value);
+	static uint64_t bucketValue(int bucket);
+private:
+	std::atomic<uint32_t> buckets[HISTOGRAM_BUCKETS];
+	std::atomic<uint64_t> total;
+	std::atomic<uint64_t> valueSum;
+};
+
+class MetricsRegistry {
+public:
+	MetricsRegistry();
+	~MetricsRegistry();
+	MetricCounter *counter(const string &name, const string &help);
+	MetricGauge *gauge(const string &name, const string &help);
+	MetricHistogram *histogram(const string &name, const string &help);
+
+	void setOutput(const string &path, float intervalMs);
+	bool enabled() const { return !outputPath.empty(); }
+	void update(float now);
+	void format(string &out) const;
+	bool flush();
+private:
+	enum MetricType { TypeCounter, TypeGauge, TypeHistogram };
+	struct Entry {
+		string name, help;
+		MetricType type;
+		void *metric;
+	};
+	vector<Entry> entries;
+	string outputPath;
+	float interval;
+	float lastFlush;
+	string text;       // kept between flushes so formatting does not allocate
+};
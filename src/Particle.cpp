@@ -1,4 +1,5 @@
 #include "Particle.h"
+#include "RenderBackend.h"
 
 
 Particle::Particle() {
@@ -23,9 +24,10 @@ void Particle::setColor(ofColor color) {
 }
 
 void Particle::draw() {
-	ofSetColor(color);
+	RenderBackend *render = RenderBackend::get();
+	render->setColor(color);
 	//    ofSetColor(ofMap(age(), 0, lifespan, 255, 10), 0, 0);
-	ofDrawSphere(position, radius);
+	render->drawCircle(position, radius);
 }
 
 // write your own integrator here.. (hint: it's only 3 lines of code)
@@ -0,0 +1,65 @@
+#include "ParticleCurve.h"
+
+ParticleCurve::ParticleCurve() {
+	clear();
+	bake();
+}
+
+void ParticleCurve::clear() {
+	colorKeys.clear();
+	sizeKeys.clear();
+}
+
+//  Keys can be added in any order
+//
+void ParticleCurve::addColorKey(float t, const ofColor &color) {
+	ColorKey k = { ofClamp(t, 0, 1), color };
+	int i = colorKeys.size();
+	colorKeys.push_back(k);
+	for (; i > 0 && colorKeys[i - 1].t > k.t; i--) colorKeys[i] = colorKeys[i - 1];
+	colorKeys[i] = k;
+}
+
+void ParticleCurve::addSizeKey(float t, float scale) {
+	SizeKey k = { ofClamp(t, 0, 1), scale };
+	int i = sizeKeys.size();
+	sizeKeys.push_back(k);
+	for (; i > 0 && sizeKeys[i - 1].t > k.t; i--) sizeKeys[i] = sizeKeys[i - 1];
+	sizeKeys[i] = k;
+}
+
+//  Sample the keys linearly into the tables. With no keys the curve is
+//  flat white at full size; outside the first and last key the nearest
+//  key's value is held.
+//
+void ParticleCurve::bake() {
+	int c = 0, s = 0;
+	for (int i = 0; i < CURVE_SAMPLES; i++) {
+		float t = (float)i / (CURVE_SAMPLES - 1);
+
+		while (c + 1 < colorKeys.size() && colorKeys[c + 1].t <= t) c++;
+		if (colorKeys.empty()) colors[i] = ofColor::white;
+		else if (c + 1 >= colorKeys.size() || t <= colorKeys[c].t) colors[i] = colorKeys[c].color;
+		else {
+			const ColorKey &a = colorKeys[c];
+			const ColorKey &b = colorKeys[c + 1];
+			colors[i] = a.color.getLerped(b.color, (t - a.t) / (b.t - a.t));
+		}
+
+		while (s + 1 < sizeKeys.size() && sizeKeys[s + 1].t <= t) s++;
+		if (sizeKeys.empty()) sizes[i] = 1;
+		else if (s + 1 >= sizeKeys.size() || t <= sizeKeys[s].t) sizes[i] = sizeKeys[s].scale;
+		else {
+			const SizeKey &a = sizeKeys[s];
+			const SizeKey &b = sizeKeys[s + 1];
+			sizes[i] = ofLerp(a.scale, b.scale, (t - a.t) / (b.t - a.t));
+		}
+	}
+}
+
+//  Table index for normalized age t
+//
+int ParticleCurve::index(float t) const {
+	int i = (int)(t * (CURVE_SAMPLES - 1) + 0.5f);
+	return i < 0 ? 0 : (i >= CURVE_SAMPLES ? CURVE_SAMPLES - 1 : i);
+}
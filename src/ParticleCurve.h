@@ -0,0 +1,33 @@
+#pragma once
+#include "ofMain.h"
+
+//  Color and size over a particle's lifetime. Keys are placed at
+//  normalized ages (0 at birth, 1 at the end of the lifespan) and bake()
+//  interpolates them into lookup tables, so evaluating a particle is one
+//  table read instead of searching and blending keys.
+//
+#define CURVE_SAMPLES 64
+
+class ParticleCurve {
+public:
+	ParticleCurve();
+	void clear();
+	void addColorKey(float t, const ofColor &color);
+	void addSizeKey(float t, float scale);
+	void bake();
+	int index(float t) const;
+
+	ofColor colors[CURVE_SAMPLES];
+	float sizes[CURVE_SAMPLES];     // multiplies the particle radius
+private:
+	struct ColorKey {
+		float t;
+		ofColor color;
+	};
+	struct SizeKey {
+		float t;
+		float scale;
+	};
+	vector<ColorKey> colorKeys;
+	vector<SizeKey> sizeKeys;
+};
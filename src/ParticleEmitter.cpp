@@ -1,4 +1,6 @@
 #include "ParticleEmitter.h"
+#include "RenderBackend.h"
+#include "MemoryTracker.h"
 
 ParticleEmitter::ParticleEmitter() {
 	sys = new ParticleSystem();
@@ -44,13 +46,14 @@ void ParticleEmitter::init() {
 
 void ParticleEmitter::draw() {
 	if (visible) {
+		RenderBackend *render = RenderBackend::get();
 		switch (type) {
 		case DirectionalEmitter:
-			ofDrawSphere(position, radius / 10);  // just draw a small sphere for point emitters 
+			render->drawCircle(position, radius / 10);  // just draw a small sphere for point emitters 
 			break;
 		case SphereEmitter:
 		case RadialEmitter:
-			ofDrawSphere(position, radius / 10);  // just draw a small sphere as a placeholder
+			render->drawCircle(position, radius / 10);  // just draw a small sphere as a placeholder
 			break;
 		default:
 			break;
@@ -68,6 +71,7 @@ void ParticleEmitter::stop() {
 	fired = false;
 }
 void ParticleEmitter::update() {
+	MemoryScope scope(MemParticles);
 
 	float time = ofGetElapsedTimeMillis();
 
@@ -2,9 +2,13 @@
 // Kevin M.Smith - CS 134 SJSU
 
 #include "ParticleSystem.h"
+#include "MemoryTracker.h"
 
 void ParticleSystem::add(const Particle &p) {
+	if (maxParticles >= 0 && particles.size() >= maxParticles) return;
+	MemoryScope scope(MemParticles);
 	particles.push_back(p);
+	indexDirty = true;
 }
 
 void ParticleSystem::addForce(ParticleForce *f) {
@@ -13,6 +17,7 @@ void ParticleSystem::addForce(ParticleForce *f) {
 
 void ParticleSystem::remove(int i) {
 	particles.erase(particles.begin() + i);
+	indexDirty = true;
 }
 
 void ParticleSystem::setLifespan(float l) {
@@ -30,6 +35,7 @@ void ParticleSystem::reset() {
 void ParticleSystem::update() {
 	// check if empty and just return
 	if (particles.size() == 0) return;
+	indexDirty = true;
 
 	vector<Particle>::iterator p = particles.begin();
 	vector<Particle>::iterator tmp;
@@ -50,7 +56,7 @@ void ParticleSystem::update() {
 	//
 	for (int i = 0; i < particles.size(); i++) {
 		for (int k = 0; k < forces.size(); k++) {
-			if (!forces[k]->applied)
+			if (!forces[k]->applied && forces[k]->enabled)
 				forces[k]->updateForce( &particles[i] );
 		}
 	}
@@ -70,9 +76,55 @@ void ParticleSystem::update() {
 
 }
 
-// remove all particlies within "dist" of point (not implemented as yet)
+//  Sort the particle positions into the grid. Only done when a query
+//  comes after the particles have moved or changed, so systems nobody
+//  queries never pay for it.
 //
-int ParticleSystem::removeNear(const ofVec3f & point, float dist) { return 0; }
+void ParticleSystem::buildIndex() {
+	MemoryScope scope(MemParticles);
+	if (!indexDirty) return;
+	int n = particles.size();
+	indexX.resize(n);
+	indexY.resize(n);
+	for (int i = 0; i < n; i++) {
+		indexX[i] = particles[i].position.x;
+		indexY[i] = particles[i].position.y;
+	}
+	grid.build(indexX.data(), indexY.data(), n, indexCellSize);
+	indexDirty = false;
+}
+
+//  Append the indices of the particles within dist of point (x, y only)
+//
+void ParticleSystem::queryRadius(const ofVec3f &point, float dist, vector<int> &out) {
+	buildIndex();
+	grid.queryRadius(point.x, point.y, dist, out);
+}
+
+//  Append the indices of the particles inside the rectangle min..max
+//
+void ParticleSystem::queryRect(const ofVec3f &min, const ofVec3f &max, vector<int> &out) {
+	buildIndex();
+	grid.queryRect(min.x, min.y, max.x, max.y, out);
+}
+
+// remove all particlies within "dist" of point and return how many were
+// removed. Each one is replaced by the last particle, highest index first,
+// so the cost depends on the number removed, not the size of the system;
+// the order of the remaining particles changes.
+//
+int ParticleSystem::removeNear(const ofVec3f & point, float dist) {
+	found.clear();
+	queryRadius(point, dist, found);
+	if (found.empty()) return 0;
+	std::sort(found.begin(), found.end(), std::greater<int>());
+	for (int k = 0; k < found.size(); k++) {
+		particles[found[k]] = particles.back();
+		particles.pop_back();
+	}
+	indexDirty = true;
+	return found.size();
+}
 
 //  draw the particle cloud
 //
@@ -83,6 +135,32 @@ void ParticleSystem::draw() {
 }
 
 
+//  Append a circle per particle for a batched draw at "time" (ms). With a
+//  curve, every particle's normalized age picks its color and size from
+//  the curve's tables in the same pass.
+//
+void ParticleSystem::appendCircles(float time, vector<CircleDraw> &out) const {
+	size_t first = out.size();
+	out.resize(first + particles.size());
+	CircleDraw *dst = out.data() + first;
+	if (curve == NULL) {
+		for (int i = 0; i < particles.size(); i++) {
+			dst[i].center = particles[i].position;
+			dst[i].radius = particles[i].radius;
+			dst[i].color = particles[i].color;
+		}
+		return;
+	}
+	for (int i = 0; i < particles.size(); i++) {
+		const Particle &p = particles[i];
+		float t = (p.lifespan > 0) ? (time - p.birthtime) / (p.lifespan * 1000) : 0;
+		int k = curve->index(t);
+		dst[i].center = p.position;
+		dst[i].radius = p.radius * curve->sizes[k];
+		dst[i].color = curve->colors[k];
+	}
+}
+
 // Gravity Force Field 
 //
 GravityForce::GravityForce(const ofVec3f &g) {
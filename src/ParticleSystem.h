@@ -4,6 +4,9 @@
 #include "ofMain.h"
 #include "Particle.h"
 #include "TransformObject.h"
+#include "ParticleCurve.h"
+#include "RenderBackend.h"
+#include "SpatialGrid.h"
 
 //  Pure Virtual Function Class - must be subclassed to create new forces.
 //
@@ -12,6 +15,7 @@ protected:
 public:
 	bool applyOnce = false;
 	bool applied = false;
+	bool enabled = true;     // disabled forces are skipped in update()
 	virtual void updateForce(Particle *) = 0;
 };
 
@@ -24,9 +28,23 @@ public:
 	void setLifespan(float);
 	void reset();
 	int removeNear(const ofVec3f & point, float dist);
+	void queryRadius(const ofVec3f &point, float dist, vector<int> &out);
+	void queryRect(const ofVec3f &min, const ofVec3f &max, vector<int> &out);
+	void invalidateIndex() { indexDirty = true; }   // after changing particles directly
 	void draw();
+	void appendCircles(float time, vector<CircleDraw> &out) const;
 	vector<Particle> particles;
 	vector<ParticleForce *> forces;
+	int maxParticles = -1;   // add() drops particles beyond this, -1 => no cap
+	const ParticleCurve *curve = NULL;   // color/size over lifetime, NULL => flat color
+	float indexCellSize = 32;
+
+private:
+	void buildIndex();
+	SpatialGrid grid;        // particle positions, rebuilt by the first query after a change
+	bool indexDirty = true;
+	vector<float> indexX, indexY;
+	vector<int> found;
 };
 
 
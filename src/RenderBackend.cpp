@@ -0,0 +1,118 @@
+#include "RenderBackend.h"
+
+static GLRenderBackend glBackend;
+static RenderBackend *currentBackend = &glBackend;
+
+RenderBackend *RenderBackend::get() {
+	return currentBackend;
+}
+
+//  Select the backend used for all drawing. Passing NULL restores the
+//  default GL backend.
+//
+void RenderBackend::set(RenderBackend *backend) {
+	currentBackend = backend ? backend : &glBackend;
+}
+
+void GLRenderBackend::setColor(const ofColor &c) {
+	ofSetColor(c);
+}
+
+void GLRenderBackend::drawImage(const ofImage &img, const glm::mat4 &m, float x, float y) {
+	ofPushMatrix();
+	ofMultMatrix(m);
+	img.draw(x, y);
+	ofPopMatrix();
+}
+
+void GLRenderBackend::drawImage(const ofImage &img, float x, float y, float w, float h) {
+	img.draw(x, y, w, h);
+}
+
+void GLRenderBackend::drawRectangle(float x, float y, float w, float h) {
+	ofDrawRectangle(x, y, w, h);
+}
+
+void GLRenderBackend::drawCircle(const glm::vec3 &center, float radius) {
+	ofDrawSphere(center, radius);
+}
+
+//  All circles go into one triangle mesh with per vertex colors and are
+//  drawn with a single call.
+//
+#define CIRCLE_SEGMENTS 12
+
+void GLRenderBackend::drawCircles(const CircleDraw *circles, int count) {
+	static float unitX[CIRCLE_SEGMENTS + 1], unitY[CIRCLE_SEGMENTS + 1];
+	static bool haveUnit = false;
+	if (!haveUnit) {
+		for (int s = 0; s <= CIRCLE_SEGMENTS; s++) {
+			unitX[s] = cos(TWO_PI * s / CIRCLE_SEGMENTS);
+			unitY[s] = sin(TWO_PI * s / CIRCLE_SEGMENTS);
+		}
+		haveUnit = true;
+	}
+	if (count == 0) return;
+
+	vector<glm::vec3> &verts = circleMesh.getVertices();
+	vector<ofFloatColor> &colors = circleMesh.getColors();
+	circleMesh.setMode(OF_PRIMITIVE_TRIANGLES);
+	verts.resize(count * CIRCLE_SEGMENTS * 3);
+	colors.resize(count * CIRCLE_SEGMENTS * 3);
+	int v = 0;
+	for (int i = 0; i < count; i++) {
+		const CircleDraw &c = circles[i];
+		ofFloatColor color = c.color;
+		for (int s = 0; s < CIRCLE_SEGMENTS; s++, v += 3) {
+			verts[v] = c.center;
+			verts[v + 1] = c.center + glm::vec3(unitX[s] * c.radius, unitY[s] * c.radius, 0);
+			verts[v + 2] = c.center + glm::vec3(unitX[s + 1] * c.radius, unitY[s + 1] * c.radius, 0);
+			colors[v] = colors[v + 1] = colors[v + 2] = color;
+		}
+	}
+	ofSetColor(255, 255, 255);
+	circleMesh.draw();
+}
+
+void GLRenderBackend::drawString(const ofTrueTypeFont &font, const string &text, float x, float y) {
+	font.drawString(text, x, y);
+}
+
+//  Render the image scaled to the window into an fbo once; drawing the fbo
+//  afterwards is a 1:1 copy with no resampling of the source image.
+//
+void GLRenderBackend::prepareLayer(StaticLayer &layer, int w, int h) {
+	layer.width = w;
+	layer.height = h;
+	layer.fbo.allocate(w, h, GL_RGBA);
+	layer.fbo.begin();
+	ofClear(0, 0, 0, 255);
+	ofSetColor(255, 255, 255);
+	layer.image->draw(0, 0, w, h);
+	layer.fbo.end();
+}
+
+void GLRenderBackend::drawLayer(const StaticLayer &layer) {
+	ofSetColor(255, 255, 255);
+	layer.fbo.draw(0, 0);
+}
+
+//  The mesh already holds the glyph quads, so this is one bind and one draw
+//  instead of a layout pass over the string.
+//
+void GLRenderBackend::drawTextMesh(const ofTrueTypeFont &font, const ofVboMesh &mesh, const string &text, float x, float y) {
+	ofPushMatrix();
+	ofTranslate(x, y);
+	font.getFontTexture().bind();
+	mesh.draw();
+	font.getFontTexture().unbind();
+	ofPopMatrix();
+}
+
+float GLRenderBackend::stringWidth(const ofTrueTypeFont &font, const string &text) {
+	return font.stringWidth(text);
+}
+
+float GLRenderBackend::stringHeight(const ofTrueTypeFont &font, const string &text) {
+	return font.stringHeight(text);
+}
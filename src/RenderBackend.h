@@ -0,0 +1,83 @@
+#pragma once
+#include "ofMain.h"
+
+//  A full window image that never changes (backgrounds, title and end
+//  screens). Backends keep a copy pre-scaled to the window so it does not
+//  have to be resampled every frame.
+//
+struct StaticLayer {
+	const ofImage *image;
+	int width, height;   // size the cache was built for
+	ofFbo fbo;           // GL cache
+	ofPixels pixels;     // software cache, RGBA
+};
+
+//  One filled circle of a batch drawn with drawCircles()
+//
+struct CircleDraw {
+	glm::vec3 center;
+	float radius;
+	ofColor color;
+};
+
+//  Abstract drawing interface used by Sprite, Emitter, Particle and ofApp.
+//  The default backend forwards to the normal openFrameworks GL calls; the
+//  SoftwareRenderer backend rasterizes into a CPU pixel buffer so the game
+//  can be drawn on machines without a GPU.
+//
+class RenderBackend {
+public:
+	virtual ~RenderBackend() {}
+	virtual void begin() {}
+	virtual void end() {}
+	virtual bool isSoftware() const { return false; }
+	virtual void setColor(const ofColor &c) = 0;
+
+	// draw image at its native size with its top left corner at (x, y) in
+	// the local space of matrix m
+	//
+	virtual void drawImage(const ofImage &img, const glm::mat4 &m, float x, float y) = 0;
+
+	// draw image stretched to the screen rectangle (x, y, w, h)
+	//
+	virtual void drawImage(const ofImage &img, float x, float y, float w, float h) = 0;
+
+	virtual void drawRectangle(float x, float y, float w, float h) = 0;
+	virtual void drawCircle(const glm::vec3 &center, float radius) = 0;
+	virtual void drawCircles(const CircleDraw *circles, int count) = 0;
+	virtual void drawString(const ofTrueTypeFont &font, const string &text, float x, float y) = 0;
+
+	// build the window sized cache of a static layer, then draw it at (0, 0)
+	//
+	virtual void prepareLayer(StaticLayer &layer, int w, int h) = 0;
+	virtual void drawLayer(const StaticLayer &layer) = 0;
+
+	// draw a string whose quads were prebuilt with font.getStringMesh(text, 0, 0)
+	//
+	virtual void drawTextMesh(const ofTrueTypeFont &font, const ofVboMesh &mesh, const string &text, float x, float y) = 0;
+	virtual float stringWidth(const ofTrueTypeFont &font, const string &text) = 0;
+	virtual float stringHeight(const ofTrueTypeFont &font, const string &text) = 0;
+
+	static RenderBackend *get();
+	static void set(RenderBackend *backend);
+};
+
+//  Backend that draws through the live OpenGL context
+//
+class GLRenderBackend : public RenderBackend {
+public:
+	void setColor(const ofColor &c);
+	void drawImage(const ofImage &img, const glm::mat4 &m, float x, float y);
+	void drawImage(const ofImage &img, float x, float y, float w, float h);
+	void drawRectangle(float x, float y, float w, float h);
+	void drawCircle(const glm::vec3 &center, float radius);
+	void drawCircles(const CircleDraw *circles, int count);
+	void drawString(const ofTrueTypeFont &font, const string &text, float x, float y);
+	void drawTextMesh(const ofTrueTypeFont &font, const ofVboMesh &mesh, const string &text, float x, float y);
+	void prepareLayer(StaticLayer &layer, int w, int h);
+	void drawLayer(const StaticLayer &layer);
+	float stringWidth(const ofTrueTypeFont &font, const string &text);
+	float stringHeight(const ofTrueTypeFont &font, const string &text);
+private:
+	ofVboMesh circleMesh;   // reused by drawCircles()
+};
@@ -0,0 +1,70 @@
+#include "RenderSnapshot.h"
+#include "ofApp.h"
+#include "GameSnapshot.h"
+
+#define FRESH_BIT 4
+
+//  Record the frame in the same order draw() used to draw the live objects
+//
+void RenderSnapshot::capture(const ofApp &app) {
+	images.clear();
+	circles.clear();
+	gameState = GameSnapshot::stateToInt(app.game_state);
+	score = app.score;
+	life = app.health.get(app.turret->healthSlot);
+
+	if (app.game_state == "game") {
+		addEmitter(app.turret, app.health.isAlive(app.turret->healthSlot), &app.bulletImage);
+		addEmitter(app.enemy, true, &app.targetImage);
+		addEmitter(app.enemyT, true, &app.targetImage);
+	}
+	addParticles(app.explosion);
+}
+
+//  Sprites of a hidden emitter are still drawn; their images are copies of
+//  spriteImage, so that is what is referenced.
+//
+void RenderSnapshot::addEmitter(const Emitter *emitter, bool drawEmitter, const ofImage *spriteImage) {
+	if (drawEmitter && emitter->drawable && emitter->haveImage) {
+		ImageDraw d = { &emitter->image, emitter->getMatrix(), -emitter->image.getWidth() / 2.0f, -emitter->image.getHeight() / 2.0f };
+		images.push_back(d);
+	}
+	const vector<Sprite> &sprites = emitter->sys->sprites;
+	for (int i = 0; i < sprites.size(); i++) {
+		const Sprite &s = sprites[i];
+		ImageDraw d = { spriteImage, s.getMatrix(), -s.width / 2.0f, -s.height / 2.0f };
+		images.push_back(d);
+	}
+}
+
+void RenderSnapshot::addParticles(const ParticleEmitter &emitter) {
+	if (emitter.visible) {
+		CircleDraw c = { emitter.position, emitter.radius / 10, ofColor::white };
+		circles.push_back(c);
+	}
+	emitter.sys->appendCircles(ofGetElapsedTimeMillis(), circles);
+}
+
+RenderSnapshotBuffer::RenderSnapshotBuffer() {
+	back = 0;
+	middle.store(1, std::memory_order_relaxed);
+	front = 2;
+}
+
+//  Hand the filled back buffer over and take the middle one to write next
+//
+void RenderSnapshotBuffer::publish() {
+	int old = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel);
+	back = old & ~FRESH_BIT;
+}
+
+//  Swap in the newest published snapshot, if there is one the reader has
+//  not seen yet
+//
+const RenderSnapshot &RenderSnapshotBuffer::latest() {
+	if (middle.load(std::memory_order_relaxed) & FRESH_BIT) {
+		int old = middle.exchange(front, std::memory_order_acq_rel);
+		front = old & ~FRESH_BIT;
+	}
+	return slots[front];
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "ofMain.h"
+#include "RenderBackend.h"
+#include <atomic>
+
+class ofApp;
+class Emitter;
+class SpriteSystem;
+class ParticleEmitter;
+
+//  Everything draw() needs from one simulation step, copied out so the
+//  simulation can move on while the frame is being drawn. Images are
+//  referenced by pointer to the app's loaded images, which live as long as
+//  the app; all other state is copied by value.
+//
+struct ImageDraw {
+	const ofImage *image;
+	glm::mat4 matrix;
+	float x, y;          // top left corner in the matrix's local space
+};
+
+class RenderSnapshot {
+public:
+	void capture(const ofApp &app);
+
+	int gameState;               // see GameSnapshot::stateToInt()
+	int score;
+	int life;
+	vector<ImageDraw> images;    // emitters and sprites, in draw order
+	vector<CircleDraw> circles;  // explosion emitter and particles
+	uint64_t step;               // simulation step that produced it
+private:
+	void addEmitter(const Emitter *emitter, bool drawEmitter, const ofImage *spriteImage);
+	void addParticles(const ParticleEmitter &emitter);
+};
+
+//  Triple buffer of render snapshots between one writer (the simulation)
+//  and one reader (draw). The writer always has a free buffer to fill and
+//  the reader always gets the newest complete snapshot; neither ever
+//  waits. Buffers are reused, so after warm up capturing does not allocate.
+//
+class RenderSnapshotBuffer {
+public:
+	RenderSnapshotBuffer();
+	RenderSnapshot &writeBuffer() { return slots[back]; }
+	void publish();
+	const RenderSnapshot &latest();
+private:
+	RenderSnapshot slots[3];
+	int back;                      // owned by the writer
+	int front;                     // owned by the reader
+	std::atomic<int> middle;       // slot index, plus FRESH_BIT when unread
+};
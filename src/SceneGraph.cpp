@@ -0,0 +1,90 @@
+#include "SceneGraph.h"
+#include "ofApp.h"
+
+//  cos and sin of a rotation in degrees; fixed point in fixed step mode, so
+//  lockstep peers get the same bits
+//
+static void rotationCosSin(float degrees, float &c, float &s) {
+	if (GameClock::isFixed()) {
+		fixed16 r = fixedMul(toFixed(degrees), FIXED_DEG_TO_RAD);
+		c = toFloat(fixedCos(r));
+		s = toFloat(fixedSin(r));
+	}
+	else {
+		c = cos(glm::radians(degrees));
+		s = sin(glm::radians(degrees));
+	}
+}
+
+//  Add a node under parent (-1 for a root) and return its id. Rotation is
+//  in degrees, relative to the parent.
+//
+int SceneGraph::add(int p, const float2 &offset, float rotation) {
+	if (p >= size()) {
+		cout << "scene graph: parent " << p << " does not exist, adding a root" << endl;
+		p = -1;
+	}
+	parent.push_back(p);
+	object.push_back(NULL);
+	localX.push_back(offset.x);
+	localY.push_back(offset.y);
+	localRot.push_back(rotation);
+	float c, s;
+	rotationCosSin(rotation, c, s);
+	localCos.push_back(c);
+	localSin.push_back(s);
+	worldX.push_back(offset.x);
+	worldY.push_back(offset.y);
+	worldRot.push_back(rotation);
+	worldCos.push_back(localCos.back());
+	worldSin.push_back(localSin.back());
+	return size() - 1;
+}
+
+//  The root node follows object's trans and rotation
+//
+void SceneGraph::bind(int node, BaseObject *o) {
+	object[node] = o;
+}
+
+void SceneGraph::update() {
+	for (int i = 0; i < size(); i++) {
+		int p = parent[i];
+		if (p < 0) {
+			if (object[i] != NULL) {
+				localX[i] = object[i]->trans.x;
+				localY[i] = object[i]->trans.y;
+				localRot[i] = object[i]->rotation;
+			}
+			worldX[i] = localX[i];
+			worldY[i] = localY[i];
+			worldRot[i] = localRot[i];
+			rotationCosSin(worldRot[i], worldCos[i], worldSin[i]);
+			continue;
+		}
+
+		// rotate the offset into the parent's frame and add the rotations
+		//
+		float c = worldCos[p], s = worldSin[p];
+		worldX[i] = worldX[p] + c * localX[i] - s * localY[i];
+		worldY[i] = worldY[p] + s * localX[i] + c * localY[i];
+		worldRot[i] = worldRot[p] + localRot[i];
+		worldCos[i] = c * localCos[i] - s * localSin[i];
+		worldSin[i] = s * localCos[i] + c * localSin[i];
+	}
+}
+
+void SceneGraph::clear() {
+	parent.clear();
+	object.clear();
+	localX.clear();
+	localY.clear();
+	localRot.clear();
+	localCos.clear();
+	localSin.clear();
+	worldX.clear();
+	worldY.clear();
+	worldRot.clear();
+	worldCos.clear();
+	worldSin.clear();
+}
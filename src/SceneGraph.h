@@ -0,0 +1,39 @@
+#pragma once
+#include "ofMain.h"
+#include "VecMath.h"
+
+class BaseObject;
+
+//  Flat 2D scene graph. Nodes live in parallel arrays indexed by node id,
+//  and a node's parent always has a smaller id, so update() is one forward
+//  pass with no recursion and no matrix stack: each node's world transform
+//  is its parent's world transform applied to its local offset and
+//  rotation.
+//
+//  A root node can be bound to a game object, whose trans and rotation it
+//  takes at every update(). Only roots do trig; a child's world rotation is
+//  built from its parent's cos/sin and its own, which are fixed when it is
+//  added. In fixed step mode (GameClock::isFixed()) both use the fixed
+//  point sin/cos, so lockstep peers agree. GameClock::setFixedStep() must
+//  come before the first add().
+//
+//  Local offsets are in the parent's frame, where -y points forward: a
+//  barrel at (0, -20) sits 20 pixels in front of the turret's center.
+//
+class SceneGraph {
+public:
+	int add(int parent, const float2 &offset, float rotation = 0);
+	void bind(int node, BaseObject *object);
+	void update();
+	void clear();
+	int size() const { return parent.size(); }
+
+	float2 position(int node) const { return float2(worldX[node], worldY[node]); }
+	float2 forward(int node) const { return float2(worldSin[node], -worldCos[node]); }   // "head"
+	float2 right(int node) const { return float2(worldCos[node], worldSin[node]); }      // "left"
+
+	vector<int> parent;               // -1 => root
+	vector<BaseObject *> object;      // roots only, may be NULL
+	vector<float> localX, localY, localRot, localCos, localSin;
+	vector<float> worldX, worldY, worldRot, worldCos, worldSin;
+};
@@ -0,0 +1,35 @@
+#include "SimulationThread.h"
+#include "ofApp.h"
+
+SimulationThread::SimulationThread() {
+	app = NULL;
+	steps = 0;
+	lateSteps = 0;
+	periodMicros = 16667;
+}
+
+void SimulationThread::setup(ofApp *a, float stepsPerSecond) {
+	app = a;
+	periodMicros = 1000000 / stepsPerSecond;
+}
+
+//  Step on a fixed schedule; a step that overruns is followed immediately
+//  by the next one rather than trying to catch up with a burst.
+//
+void SimulationThread::threadedFunction() {
+	uint64_t next = ofGetElapsedTimeMicros();
+	while (isThreadRunning()) {
+		app->simulate();
+		steps++;
+
+		next += periodMicros;
+		uint64_t now = ofGetElapsedTimeMicros();
+		if (now < next) {
+			std::this_thread::sleep_for(std::chrono::microseconds(next - now));
+		}
+		else {
+			lateSteps++;
+			next = now;
+		}
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "ofMain.h"
+
+class ofApp;
+
+//  Runs ofApp::simulate() on a worker thread at a fixed rate so a slow
+//  simulation step does not hold up drawing, and drawing does not hold up
+//  the simulation. Each step publishes a RenderSnapshot that draw() picks
+//  up on the main thread.
+//
+class SimulationThread : public ofThread {
+public:
+	SimulationThread();
+	void setup(ofApp *app, float stepsPerSecond);
+	void threadedFunction();
+
+	uint64_t steps;
+	uint64_t lateSteps;  // steps that started after their deadline
+private:
+	ofApp *app;
+	uint64_t periodMicros;
+};
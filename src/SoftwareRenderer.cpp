@@ -0,0 +1,413 @@
+#include "SoftwareRenderer.h"
+#include "VecMath.h"
+
+//  5x7 bitmap font, one byte per row with the leftmost pixel in bit 4.
+//  Lower case letters are drawn with the upper case glyphs.
+//
+struct Glyph {
+	char c;
+	unsigned char rows[7];
+};
+
+static const Glyph font5x7[] = {
+	{ 'A', { 0x0e, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 } },
+	{ 'B', { 0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e } },
+	{ 'C', { 0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e } },
+	{ 'D', { 0x1e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1e } },
+	{ 'E', { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f } },
+	{ 'F', { 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10 } },
+	{ 'G', { 0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f } },
+	{ 'H', { 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 } },
+	{ 'I', { 0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e } },
+	{ 'J', { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c } },
+	{ 'K', { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 } },
+	{ 'L', { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f } },
+	{ 'M', { 0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11 } },
+	{ 'N', { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 } },
+	{ 'O', { 0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e } },
+	{ 'P', { 0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10 } },
+	{ 'Q', { 0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d } },
+	{ 'R', { 0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11 } },
+	{ 'S', { 0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e } },
+	{ 'T', { 0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 } },
+	{ 'U', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e } },
+	{ 'V', { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04 } },
+	{ 'W', { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a } },
+	{ 'X', { 0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11 } },
+	{ 'Y', { 0x11, 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04 } },
+	{ 'Z', { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f } },
+	{ '0', { 0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e } },
+	{ '1', { 0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e } },
+	{ '2', { 0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f } },
+	{ '3', { 0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e } },
+	{ '4', { 0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02 } },
+	{ '5', { 0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e } },
+	{ '6', { 0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e } },
+	{ '7', { 0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 } },
+	{ '8', { 0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e } },
+	{ '9', { 0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c } },
+	{ ':', { 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00 } },
+	{ '!', { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 } },
+	{ '-', { 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00 } },
+	{ '.', { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c } },
+};
+
+static const Glyph *findGlyph(char c) {
+	if (c >= 'a' && c <= 'z') c = c - 'a' + 'A';
+	for (int i = 0; i < sizeof(font5x7) / sizeof(Glyph); i++) {
+		if (font5x7[i].c == c) return &font5x7[i];
+	}
+	return NULL;
+}
+
+//  Blend a source pixel with "channels" components over an RGBA destination
+//
+static inline void blendPixel(unsigned char *dst, const unsigned char *src, int channels) {
+	if (channels == 4) {
+		int a = src[3];
+		if (a == 0) return;
+		if (a == 255) {
+			dst[0] = src[0];
+			dst[1] = src[1];
+			dst[2] = src[2];
+		}
+		else {
+			int ia = 255 - a;
+			dst[0] = (src[0] * a + dst[0] * ia) / 255;
+			dst[1] = (src[1] * a + dst[1] * ia) / 255;
+			dst[2] = (src[2] * a + dst[2] * ia) / 255;
+		}
+	}
+	else if (channels == 3) {
+		dst[0] = src[0];
+		dst[1] = src[1];
+		dst[2] = src[2];
+	}
+	else {
+		dst[0] = dst[1] = dst[2] = src[0];
+	}
+	dst[3] = 255;
+}
+
+SoftwareRenderer::SoftwareRenderer() {
+	width = 0;
+	height = 0;
+	color = ofColor::white;
+	clearColor = ofColor(0, 0, 0, 255);
+	textScale = 4;
+	dumpFrames = false;
+	frameNum = 0;
+	restoredPixels = 0;
+	lastLayer = NULL;
+	needsBase = true;
+}
+
+void SoftwareRenderer::allocate(int w, int h) {
+	width = w;
+	height = h;
+	pixels.allocate(w, h, OF_IMAGE_COLOR_ALPHA);
+	dirty.clear();
+	prevDirty.clear();
+	lastLayer = NULL;
+	needsBase = true;
+}
+
+//  Start a new frame. The buffer is not cleared here: if the frame starts
+//  with a static layer, drawLayer() only has to undo the last frame's
+//  draws, otherwise the first draw clears it (see ensureBase()).
+//
+void SoftwareRenderer::begin() {
+	prevDirty.swap(dirty);
+	dirty.clear();
+	needsBase = true;
+	restoredPixels = 0;
+	color = ofColor::white;
+}
+
+//  Clear to the clear color if nothing has been drawn this frame
+//
+void SoftwareRenderer::ensureBase() {
+	if (!needsBase) return;
+	needsBase = false;
+	lastLayer = NULL;
+	unsigned char *p = pixels.getData();
+	size_t rowBytes = width * 4;
+	if (height == 0) return;
+
+	// fill the first row and copy it to the others
+	//
+	for (int x = 0; x < width; x++) {
+		p[x * 4 + 0] = clearColor.r;
+		p[x * 4 + 1] = clearColor.g;
+		p[x * 4 + 2] = clearColor.b;
+		p[x * 4 + 3] = clearColor.a;
+	}
+	for (int y = 1; y < height; y++)
+		memcpy(p + y * rowBytes, p, rowBytes);
+}
+
+//  Record the screen rectangle [x0, x1) x [y0, y1) as drawn this frame
+//
+void SoftwareRenderer::markDirty(int x0, int y0, int x1, int y1) {
+	x0 = MAX(0, x0);
+	y0 = MAX(0, y0);
+	x1 = MIN(width, x1);
+	y1 = MIN(height, y1);
+	if (x0 >= x1 || y0 >= y1) return;
+	DirtyRect r = { x0, y0, x1, y1 };
+	dirty.push_back(r);
+}
+
+void SoftwareRenderer::end() {
+	ensureBase();
+	if (dumpFrames) {
+		char name[64];
+		snprintf(name, sizeof(name), "frames/frame_%05d.png", frameNum);
+		if (!saveFrame(name)) {
+			cout << "software renderer: can't save " << name << ", not dumping frames" << endl;
+			dumpFrames = false;
+		}
+	}
+	frameNum++;
+}
+
+bool SoftwareRenderer::saveFrame(const string &path) {
+	return ofSaveImage(pixels, path);
+}
+
+//  Fill pixels [x0, x1) of row y with the current color
+//
+void SoftwareRenderer::fillSpan(int y, int x0, int x1) {
+	if (y < 0 || y >= height) return;
+	if (x0 < 0) x0 = 0;
+	if (x1 > width) x1 = width;
+	unsigned char src[4] = { color.r, color.g, color.b, color.a };
+	unsigned char *dst = pixels.getData() + (y * width + x0) * 4;
+	for (int x = x0; x < x1; x++, dst += 4)
+		blendPixel(dst, src, 4);
+}
+
+//  Draw an image through an affine transform. Each destination pixel in the
+//  transformed bounding box is mapped back into image space with the inverse
+//  matrix and sampled; the inverse is stepped incrementally along each row.
+//
+void SoftwareRenderer::drawImage(const ofImage &img, const glm::mat4 &m, float x, float y) {
+	const ofPixels &src = img.getPixels();
+	if (!src.isAllocated()) return;
+	int iw = src.getWidth();
+	int ih = src.getHeight();
+	int channels = src.getNumChannels();
+
+	// 2D affine part of the matrix
+	//
+	float2x3 t = float2x3::fromMat4(m);
+	float a = t.a, b = t.b, tx = t.tx;
+	float c = t.c, d = t.d, ty = t.ty;
+	float det = a * d - b * c;
+	if (fabs(det) < 1e-6) return;
+	ensureBase();
+
+	float cx[4] = { x, x + iw, x, x + iw };
+	float cy[4] = { y, y, y + ih, y + ih };
+	float sx[4], sy[4];
+	transformMany(t, cx, cy, 4, sx, sy);
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	for (int i = 0; i < 4; i++) {
+		minX = MIN(minX, sx[i]);
+		maxX = MAX(maxX, sx[i]);
+		minY = MIN(minY, sy[i]);
+		maxY = MAX(maxY, sy[i]);
+	}
+	int x0 = MAX(0, (int)floor(minX));
+	int x1 = MIN(width, (int)ceil(maxX));
+	int y0 = MAX(0, (int)floor(minY));
+	int y1 = MIN(height, (int)ceil(maxY));
+	if (x0 >= x1 || y0 >= y1) return;
+	markDirty(x0, y0, x1, y1);
+
+	float ia = d / det, ib = -b / det;
+	float ic = -c / det, id = a / det;
+	const unsigned char *srcData = src.getData();
+	unsigned char *dstData = pixels.getData();
+
+	for (int py = y0; py < y1; py++) {
+		float dx = x0 + 0.5f - tx;
+		float dy = py + 0.5f - ty;
+		float u = ia * dx + ib * dy - x;
+		float v = ic * dx + id * dy - y;
+		unsigned char *dst = dstData + (py * width + x0) * 4;
+		for (int px = x0; px < x1; px++, dst += 4) {
+			if (u >= 0 && v >= 0 && u < iw && v < ih) {
+				blendPixel(dst, srcData + ((int)v * iw + (int)u) * channels, channels);
+			}
+			u += ia;
+			v += ic;
+		}
+	}
+}
+
+//  Draw an image stretched to a screen rectangle. The source column for
+//  every destination column is computed once up front.
+//
+void SoftwareRenderer::drawImage(const ofImage &img, float x, float y, float w, float h) {
+	const ofPixels &src = img.getPixels();
+	if (!src.isAllocated() || w <= 0 || h <= 0) return;
+	ensureBase();
+	int iw = src.getWidth();
+	int ih = src.getHeight();
+	int channels = src.getNumChannels();
+
+	int x0 = MAX(0, (int)x);
+	int x1 = MIN(width, (int)(x + w));
+	int y0 = MAX(0, (int)y);
+	int y1 = MIN(height, (int)(y + h));
+	if (x0 >= x1 || y0 >= y1) return;
+	markDirty(x0, y0, x1, y1);
+
+	vector<int> &cols = columnLookup;
+	cols.resize(x1 - x0);
+	for (int px = x0; px < x1; px++)
+		cols[px - x0] = MIN(iw - 1, (int)((px + 0.5f - x) * iw / w)) * channels;
+
+	const unsigned char *srcData = src.getData();
+	unsigned char *dstData = pixels.getData();
+	for (int py = y0; py < y1; py++) {
+		int sv = MIN(ih - 1, (int)((py + 0.5f - y) * ih / h));
+		const unsigned char *srcRow = srcData + sv * iw * channels;
+		unsigned char *dst = dstData + (py * width + x0) * 4;
+		for (int i = 0; i < cols.size(); i++, dst += 4)
+			blendPixel(dst, srcRow + cols[i], channels);
+	}
+}
+
+void SoftwareRenderer::drawRectangle(float x, float y, float w, float h) {
+	ensureBase();
+	markDirty((int)x, (int)y, (int)(x + w), (int)(y + h));
+	int y0 = MAX(0, (int)y);
+	int y1 = MIN(height, (int)(y + h));
+	for (int py = y0; py < y1; py++)
+		fillSpan(py, (int)x, (int)(x + w));
+}
+
+void SoftwareRenderer::drawCircle(const glm::vec3 &center, float radius) {
+	ensureBase();
+	markDirty((int)floor(center.x - radius), (int)floor(center.y - radius),
+		(int)ceil(center.x + radius) + 1, (int)ceil(center.y + radius));
+	int y0 = MAX(0, (int)floor(center.y - radius));
+	int y1 = MIN(height, (int)ceil(center.y + radius));
+	for (int py = y0; py < y1; py++) {
+		float dy = py + 0.5f - center.y;
+		float span = radius * radius - dy * dy;
+		if (span < 0) continue;
+		float dx = sqrt(span);
+		fillSpan(py, (int)(center.x - dx + 0.5f), (int)(center.x + dx + 0.5f));
+	}
+}
+
+void SoftwareRenderer::drawCircles(const CircleDraw *circles, int count) {
+	for (int i = 0; i < count; i++) {
+		color = circles[i].color;
+		drawCircle(circles[i].center, circles[i].radius);
+	}
+}
+
+//  Draw text with the bitmap font. (x, y) is the left end of the baseline,
+//  same as ofTrueTypeFont::drawString().
+//
+void SoftwareRenderer::drawString(const ofTrueTypeFont &font, const string &text, float x, float y) {
+	int top = (int)y - 7 * textScale;
+	int left = (int)x;
+	ensureBase();
+	markDirty(left, top, left + text.size() * 6 * textScale, top + 7 * textScale);
+	for (int i = 0; i < text.size(); i++, left += 6 * textScale) {
+		const Glyph *g = findGlyph(text[i]);
+		if (g == NULL) continue;
+		for (int row = 0; row < 7; row++) {
+			for (int col = 0; col < 5; col++) {
+				if (!(g->rows[row] & (0x10 >> col))) continue;
+				int gx = left + col * textScale;
+				for (int k = 0; k < textScale; k++)
+					fillSpan(top + row * textScale + k, gx, gx + textScale);
+			}
+		}
+	}
+}
+
+//  Pre-scale the layer image to the window, nearest neighbour, in RGBA so
+//  compositing is a plain copy.
+//
+void SoftwareRenderer::prepareLayer(StaticLayer &layer, int w, int h) {
+	layer.width = w;
+	layer.height = h;
+	layer.pixels.allocate(w, h, OF_IMAGE_COLOR_ALPHA);
+	const ofPixels &src = layer.image->getPixels();
+	unsigned char *dst = layer.pixels.getData();
+	if (!src.isAllocated()) {
+		memset(dst, 0, w * h * 4);
+		return;
+	}
+	int iw = src.getWidth();
+	int ih = src.getHeight();
+	int channels = src.getNumChannels();
+	const unsigned char *srcData = src.getData();
+	for (int py = 0; py < h; py++) {
+		int sv = MIN(ih - 1, (int)((py + 0.5f) * ih / h));
+		for (int px = 0; px < w; px++, dst += 4) {
+			int su = MIN(iw - 1, (int)((px + 0.5f) * iw / w));
+			dst[0] = dst[1] = dst[2] = 0;
+			blendPixel(dst, srcData + (sv * iw + su) * channels, channels);
+		}
+	}
+	if (lastLayer == &layer.pixels) lastLayer = NULL;
+}
+
+//  Copy a static layer over the whole window. When the previous frame was
+//  built on the same layer and this is the first draw of the frame, only
+//  the rectangles drawn last frame differ from the layer, so only those are
+//  copied back.
+//
+void SoftwareRenderer::drawLayer(const StaticLayer &layer) {
+	if (layer.width != width || layer.height != height) return;
+	const unsigned char *src = layer.pixels.getData();
+	unsigned char *dst = pixels.getData();
+
+	bool partial = needsBase && lastLayer == &layer.pixels;
+	size_t area = 0;
+	if (partial) {
+		for (int i = 0; i < prevDirty.size(); i++) {
+			const DirtyRect &r = prevDirty[i];
+			area += (r.x1 - r.x0) * (r.y1 - r.y0);
+		}
+		partial = area < (size_t)width * height;
+	}
+
+	if (partial) {
+		for (int i = 0; i < prevDirty.size(); i++) {
+			const DirtyRect &r = prevDirty[i];
+			size_t rowBytes = (r.x1 - r.x0) * 4;
+			for (int y = r.y0; y < r.y1; y++) {
+				size_t offset = (y * width + r.x0) * 4;
+				memcpy(dst + offset, src + offset, rowBytes);
+			}
+		}
+		restoredPixels += area;
+	}
+	else {
+		memcpy(dst, src, width * height * 4);
+		restoredPixels += width * height;
+		dirty.clear();
+	}
+
+	// everything drawn from here on is on top of this layer
+	//
+	lastLayer = &layer.pixels;
+	needsBase = false;
+}
+
+float SoftwareRenderer::stringWidth(const ofTrueTypeFont &font, const string &text) {
+	return text.size() * 6 * textScale;
+}
+
+float SoftwareRenderer::stringHeight(const ofTrueTypeFont &font, const string &text) {
+	return 7 * textScale;
+}
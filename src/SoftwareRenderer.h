@@ -0,0 +1,58 @@
+#pragma once
+#include "RenderBackend.h"
+
+//  CPU rasterizer backend. Everything is drawn into an RGBA ofPixels buffer
+//  so frames can be measured and compared (golden images) on machines that
+//  have no GPU. Images are sampled nearest neighbour, particles are filled
+//  discs and text uses a built in 5x7 bitmap font.
+//
+//  Static layers are composited with dirty rectangles: every draw records
+//  the screen rectangle it touched, and when the next frame starts from the
+//  same static layer only those rectangles are restored from the layer
+//  instead of copying the whole window.
+//
+//  Only translation, rotation and scale are supported in image matrices,
+//  which is all BaseObject::getMatrix() produces. The current color is used
+//  for rectangles, circles and text; images are drawn untinted.
+//
+class SoftwareRenderer : public RenderBackend {
+public:
+	SoftwareRenderer();
+	void allocate(int w, int h);
+	void begin();
+	void end();
+	bool isSoftware() const { return true; }
+	void setColor(const ofColor &c) { color = c; }
+	void drawImage(const ofImage &img, const glm::mat4 &m, float x, float y);
+	void drawImage(const ofImage &img, float x, float y, float w, float h);
+	void drawRectangle(float x, float y, float w, float h);
+	void drawCircle(const glm::vec3 &center, float radius);
+	void drawCircles(const CircleDraw *circles, int count);
+	void drawString(const ofTrueTypeFont &font, const string &text, float x, float y);
+	void drawTextMesh(const ofTrueTypeFont &font, const ofVboMesh &mesh, const string &text, float x, float y) { drawString(font, text, x, y); }
+	void prepareLayer(StaticLayer &layer, int w, int h);
+	void drawLayer(const StaticLayer &layer);
+	float stringWidth(const ofTrueTypeFont &font, const string &text);
+	float stringHeight(const ofTrueTypeFont &font, const string &text);
+	bool saveFrame(const string &path);
+
+	ofPixels pixels;      // RGBA frame buffer
+	ofColor color;
+	ofColor clearColor;
+	int textScale;        // size of one bitmap font pixel on screen
+	bool dumpFrames;      // write every frame to frames/frame_NNNNN.png
+	int frameNum;
+	int restoredPixels;   // pixels copied from static layers this frame
+private:
+	struct DirtyRect {
+		int x0, y0, x1, y1;
+	};
+	void ensureBase();
+	void markDirty(int x0, int y0, int x1, int y1);
+	void fillSpan(int y, int x0, int x1);
+	vector<int> columnLookup;   // source column offsets for stretched draws
+	vector<DirtyRect> dirty, prevDirty;
+	const ofPixels *lastLayer;  // static layer under the previous frame
+	bool needsBase;             // nothing has been drawn this frame yet
+	int width, height;
+};
@@ -0,0 +1,147 @@
+#include "SpatialGrid.h"
+#include "VecMath.h"
+
+SpatialGrid::SpatialGrid() {
+	cellSize = 64;
+	cols = rows = 0;
+	minX = minY = 0;
+}
+
+int SpatialGrid::cellX(float x) const {
+	return ofClamp((int)((x - minX) / cellSize), 0, cols - 1);
+}
+
+int SpatialGrid::cellY(float y) const {
+	return ofClamp((int)((y - minY) / cellSize), 0, rows - 1);
+}
+
+//  Rebuild the grid over n points. The grid covers the bounding box of the
+//  points, so every point falls inside a cell.
+//
+void SpatialGrid::build(const float *x, const float *y, int n, float size) {
+	cellSize = size;
+	px.assign(x, x + n);
+	py.assign(y, y + n);
+	if (n == 0) {
+		cols = rows = 0;
+		cellStart.assign(1, 0);
+		items.clear();
+		sortedX.clear();
+		sortedY.clear();
+		return;
+	}
+
+	float maxX = x[0], maxY = y[0];
+	minX = x[0];
+	minY = y[0];
+	for (int i = 1; i < n; i++) {
+		minX = MIN(minX, x[i]);
+		maxX = MAX(maxX, x[i]);
+		minY = MIN(minY, y[i]);
+		maxY = MAX(maxY, y[i]);
+	}
+	cols = (int)((maxX - minX) / cellSize) + 1;
+	rows = (int)((maxY - minY) / cellSize) + 1;
+
+	// a few stray points far away must not blow up the cell count
+	//
+	while ((long)cols * rows > 4L * n + 1024) {
+		cellSize *= 2;
+		cols = (int)((maxX - minX) / cellSize) + 1;
+		rows = (int)((maxY - minY) / cellSize) + 1;
+	}
+
+	// count the points in each cell, prefix sum into start offsets and
+	// then drop every point into its slot
+	//
+	int numCells = cols * rows;
+	cellStart.assign(numCells + 1, 0);
+	cellOf.resize(n);
+	for (int i = 0; i < n; i++) {
+		cellOf[i] = cellY(y[i]) * cols + cellX(x[i]);
+		cellStart[cellOf[i] + 1]++;
+	}
+	for (int c = 0; c < numCells; c++)
+		cellStart[c + 1] += cellStart[c];
+	cursor.assign(cellStart.begin(), cellStart.end() - 1);
+	items.resize(n);
+	sortedX.resize(n);
+	sortedY.resize(n);
+	for (int i = 0; i < n; i++) {
+		int slot = cursor[cellOf[i]]++;
+		items[slot] = i;
+		sortedX[slot] = x[i];
+		sortedY[slot] = y[i];
+	}
+}
+
+//  Append the indices of all points within r of (x, y) to out. The cells
+//  cx0..cx1 of one row are adjacent in the sorted arrays, so each row is
+//  one batch distance test.
+//
+void SpatialGrid::queryRadius(float x, float y, float r, vector<int> &out) const {
+	if (cols == 0) return;
+	if (x + r < minX || y + r < minY || x - r > minX + cols * cellSize || y - r > minY + rows * cellSize) return;
+	int cx0 = cellX(x - r), cx1 = cellX(x + r);
+	int cy0 = cellY(y - r), cy1 = cellY(y + r);
+	for (int cy = cy0; cy <= cy1; cy++) {
+		int first = cellStart[cy * cols + cx0];
+		int last = cellStart[cy * cols + cx1 + 1];
+		if (first == last) continue;
+		size_t base = out.size();
+		out.resize(base + last - first);
+		int n = withinRadius(&sortedX[first], &sortedY[first], last - first, float2(x, y), r, &out[base]);
+		for (int k = 0; k < n; k++)
+			out[base + k] = items[first + out[base + k]];
+		out.resize(base + n);
+	}
+}
+
+//  Append the indices of all points inside the rectangle to out
+//
+void SpatialGrid::queryRect(float x0, float y0, float x1, float y1, vector<int> &out) const {
+	if (cols == 0) return;
+	if (x1 < minX || y1 < minY || x0 > minX + cols * cellSize || y0 > minY + rows * cellSize) return;
+	int cx0 = cellX(x0), cx1 = cellX(x1);
+	int cy0 = cellY(y0), cy1 = cellY(y1);
+	for (int cy = cy0; cy <= cy1; cy++) {
+		for (int cx = cx0; cx <= cx1; cx++) {
+			int c = cy * cols + cx;
+			for (int k = cellStart[c]; k < cellStart[c + 1]; k++) {
+				int i = items[k];
+				if (px[i] >= x0 && px[i] <= x1 && py[i] >= y0 && py[i] <= y1) out.push_back(i);
+			}
+		}
+	}
+}
+
+//  Index of the point closest to (x, y) within maxDist, or -1. The search
+//  radius starts at one cell and doubles, so only nearby cells are visited.
+//
+int SpatialGrid::nearest(float x, float y, float maxDist) const {
+	if (cols == 0) return -1;
+	float r = MIN(cellSize, maxDist);
+	while (true) {
+		int best = -1;
+		float bestD2 = r * r;
+		int cx0 = cellX(x - r), cx1 = cellX(x + r);
+		int cy0 = cellY(y - r), cy1 = cellY(y + r);
+		for (int cy = cy0; cy <= cy1; cy++) {
+			for (int cx = cx0; cx <= cx1; cx++) {
+				int c = cy * cols + cx;
+				for (int k = cellStart[c]; k < cellStart[c + 1]; k++) {
+					int i = items[k];
+					float dx = px[i] - x;
+					float dy = py[i] - y;
+					float d2 = dx * dx + dy * dy;
+					if (d2 <= bestD2) {
+						bestD2 = d2;
+						best = i;
+					}
+				}
+			}
+		}
+		if (best >= 0 || r >= maxDist) return best;
+		r = MIN(r * 2, maxDist);
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "ofMain.h"
+
+//  Uniform grid over a set of 2D points for radius, rectangle and nearest
+//  neighbour queries. build() sorts the point indices by cell (counting
+//  sort) into one flat array, so a rebuild is O(n) and does not allocate
+//  once the buffers have grown.
+//
+class SpatialGrid {
+public:
+	SpatialGrid();
+	void build(const float *x, const float *y, int n, float cellSize);
+	void queryRadius(float x, float y, float r, vector<int> &out) const;
+	void queryRect(float x0, float y0, float x1, float y1, vector<int> &out) const;
+	int nearest(float x, float y, float maxDist) const;
+	int size() const { return px.size(); }
+
+	float cellSize;
+	int cols, rows;
+	float minX, minY;
+	vector<int> cellStart;   // items of cell c are items[cellStart[c] .. cellStart[c + 1])
+	vector<int> items;       // point indices ordered by cell
+	vector<float> px, py;    // copy of the points
+	vector<float> sortedX, sortedY;   // the points in items order
+private:
+	int cellX(float x) const;
+	int cellY(float y) const;
+	vector<int> cellOf, cursor;
+};
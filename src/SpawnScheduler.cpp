@@ -0,0 +1,165 @@
+#include "SpawnScheduler.h"
+#include "ofApp.h"
+#include "SceneGraph.h"
+
+static bool eventBefore(const SpawnEvent &a, const SpawnEvent &b) {
+	return a.time < b.time;
+}
+
+SpawnScheduler::SpawnScheduler() {
+	horizon = 500;
+	events = NULL;
+	scene = NULL;
+	next = 0;
+	compiledUntil = 0;
+}
+
+//  Add a wave and return its index. The first sprite is due one period
+//  after start, the same as Emitter::start() followed by a rate check.
+//
+int SpawnScheduler::addWave(Emitter *emitter, const ofImage *image, float rate, double start, double stop) {
+	WaveDef w;
+	w.emitter = emitter;
+	w.image = image;
+	w.rate = rate;
+	w.start = start;
+	w.stop = stop;
+	w.speed = 100;
+	w.lifespan = -1;
+	w.aim = AimEmitterVelocity;
+	w.pattern = TrajLinear;
+	w.enabled = true;
+	w.firstNode = 0;
+	w.nodes = 0;
+	w.epoch = (rate > 0) ? start + 1000.0 / rate : start;
+	w.count = 0;
+	w.lastEmitted = start;
+	w.spawned = 0;
+	waves.push_back(w);
+	compiledUntil = 0;
+	return waves.size() - 1;
+}
+
+//  Drop the pending events of a wave and start it again from its last
+//  spawn, keeping at least one period between sprites.
+//
+void SpawnScheduler::restartWave(int wave, double now) {
+	WaveDef &w = waves[wave];
+	timeline.erase(std::remove_if(timeline.begin() + next, timeline.end(),
+		[wave](const SpawnEvent &e) { return e.wave == wave; }), timeline.end());
+	w.epoch = (w.rate > 0) ? MAX(w.lastEmitted + 1000.0 / w.rate, now) : now;
+	w.count = 0;
+	compiledUntil = 0;
+}
+
+void SpawnScheduler::setRate(int wave, float rate, double now) {
+	if (waves[wave].rate == rate) return;
+	waves[wave].rate = rate;
+	restartWave(wave, now);
+}
+
+void SpawnScheduler::setEnabled(int wave, bool enabled, double now) {
+	if (waves[wave].enabled == enabled) return;
+	waves[wave].enabled = enabled;
+	restartWave(wave, now);
+}
+
+//  Rebuild the whole timeline from the emitters' last spawn times, e.g.
+//  when the game starts or a snapshot has been restored.
+//
+void SpawnScheduler::resync(double now) {
+	timeline.clear();
+	next = 0;
+	for (int i = 0; i < waves.size(); i++) {
+		waves[i].lastEmitted = waves[i].emitter->lastSpawned;
+		restartWave(i, now);
+	}
+}
+
+//  Extend the timeline to now + horizon and sort the pending events.
+//
+void SpawnScheduler::compile(double now) {
+	double until = now + horizon;
+	for (int i = 0; i < waves.size(); i++) {
+		WaveDef &w = waves[i];
+		if (!w.enabled || w.rate <= 0) continue;
+		double period = 1000.0 / w.rate;
+		while (true) {
+			double t = w.epoch + w.count * period;
+			if (t > until || (w.stop >= 0 && t > w.stop)) break;
+			SpawnEvent e;
+			e.time = t;
+			e.wave = i;
+			timeline.push_back(e);
+			w.count++;
+		}
+	}
+	std::stable_sort(timeline.begin() + next, timeline.end(), eventBefore);
+	compiledUntil = until;
+}
+
+//  Spawn every event that is due at "now" as one batch. Returns the number
+//  of sprites spawned; spawned(wave) gives the count per wave.
+//
+int SpawnScheduler::tick(double now) {
+	MemoryScope scope(MemSprites);
+	if (now + horizon / 2 > compiledUntil) compile(now);
+
+	for (int i = 0; i < waves.size(); i++)
+		waves[i].spawned = 0;
+
+	size_t end = next;
+	while (end < timeline.size() && timeline[end].time <= now) end++;
+	for (size_t i = next; i < end; i++)
+		spawn(timeline[i], now);
+	next = end;
+	int n = 0;
+	for (int i = 0; i < waves.size(); i++)
+		n += waves[i].spawned;
+
+	// drop the spawned prefix once it is larger than what is left
+	//
+	if (next > 64 && next * 2 > timeline.size()) {
+		timeline.erase(timeline.begin(), timeline.begin() + next);
+		next = 0;
+	}
+	return n;
+}
+
+//  Create the sprites for one event, one per barrel. Their birthtime and
+//  the start of their trajectories are the event time, so they are placed
+//  where they are "now".
+//
+void SpawnScheduler::spawn(const SpawnEvent &event, double now) {
+	WaveDef &w = waves[event.wave];
+	Emitter *emitter = w.emitter;
+	if (!emitter->started) return;
+
+	int barrels = (scene && w.nodes > 0) ? w.nodes : 1;
+	for (int b = 0; b < barrels; b++) {
+		glm::vec3 origin = emitter->trans;
+		ofVec3f velocity = (w.aim == AimEmitterHead) ? emitter->head * 100 : emitter->velocity;
+		if (scene && w.nodes > 0) {
+			int node = w.firstNode + b;
+			origin = scene->position(node).vec3();
+			if (w.aim == AimEmitterHead) velocity = ofVec3f(scene->forward(node).vec3() * 100);
+		}
+
+		Sprite sprite;
+		sprite.setImage(*w.image);
+		sprite.velocity = velocity;
+		sprite.lifespan = w.lifespan;
+		sprite.path = Trajectory::make(w.pattern, origin, sprite.velocity, w.speed, event.time);
+		if (w.pattern == TrajHoming) sprite.velocity = sprite.velocity.getNormalized() * w.speed;
+		sprite.setPosition(GameClock::isFixed() ? sprite.path.positionAtFixed(now) : sprite.path.positionAt(now));
+		sprite.birthtime = event.time;
+		sprite.width = emitter->childWidth;
+		sprite.height = emitter->childHeight;
+		emitter->sys->add(sprite);
+		w.spawned++;
+		if (events) events->publish(EventSpawn, event.wave, 0, sprite.trans);
+	}
+
+	emitter->lastSpawned = event.time;
+	w.lastEmitted = event.time;
+}
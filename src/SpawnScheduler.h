@@ -0,0 +1,71 @@
+#pragma once
+#include "ofMain.h"
+#include "Trajectory.h"
+#include "EventBus.h"
+
+class Emitter;
+class SceneGraph;
+
+typedef enum { AimEmitterVelocity, AimEmitterHead } SpawnAim;
+
+//  One wave of sprites fired from an emitter at a fixed rate between start
+//  and stop (ms, stop of -1 => endless). Times are doubles: as floats they
+//  drift to whole and then several ms per event after a few hours of play.
+//
+struct WaveDef {
+	Emitter *emitter;
+	const ofImage *image;
+	float rate;          // sprites/sec
+	double start;        // ms
+	double stop;         // ms
+	float speed;         // pixels/sec
+	float lifespan;      // ms
+	SpawnAim aim;
+	TrajectoryPattern pattern;
+	bool enabled;
+	int firstNode;       // barrels: scene graph nodes firstNode .. firstNode + nodes - 1
+	int nodes;           // each event fires one sprite per barrel, 0 => emitter center
+
+	// timeline state; event k of the wave is due at epoch + k * period
+	//
+	double epoch;
+	int count;
+	double lastEmitted;
+	int spawned;         // sprites spawned by the last tick()
+};
+
+struct SpawnEvent {
+	double time;         // ms
+	int wave;
+};
+
+//  Compiles wave definitions into one timeline of spawn events sorted by
+//  time. Every tick, all events that are due are spawned together; each
+//  sprite's trajectory starts at its event time, so it is already where it
+//  should be and the spawn rate does not depend on the frame rate.
+//
+//  The timeline is only compiled "horizon" ms ahead and is extended as time
+//  passes; changing a wave's rate recompiles just that wave.
+//
+class SpawnScheduler {
+public:
+	SpawnScheduler();
+	int addWave(Emitter *emitter, const ofImage *image, float rate, double start, double stop = -1);
+	void setRate(int wave, float rate, double now);
+	void setEnabled(int wave, bool enabled, double now);
+	void resync(double now);
+	int tick(double now);
+	int spawned(int wave) const { return waves[wave].spawned; }
+
+	vector<WaveDef> waves;
+	vector<SpawnEvent> timeline;
+	float horizon;       // ms
+	EventBus *events;    // receives an EventSpawn per sprite, may be NULL
+	SceneGraph *scene;   // places the barrels, must be updated before tick()
+private:
+	void compile(double now);
+	void restartWave(int wave, double now);
+	void spawn(const SpawnEvent &event, double now);
+	size_t next;         // first event in the timeline not yet spawned
+	double compiledUntil;
+};
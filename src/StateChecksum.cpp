@@ -0,0 +1,59 @@
+#include "StateChecksum.h"
+#include "ofApp.h"
+#include "GameSnapshot.h"
+
+StateChecksum::StateChecksum() {
+	last = 0;
+	hash = 0;
+	for (int i = 0; i < CHECKSUM_HISTORY; i++) {
+		ticks[i] = 0xffffffff;
+		sums[i] = 0;
+	}
+}
+
+void StateChecksum::add(const void *data, size_t size) {
+	const unsigned char *p = (const unsigned char *)data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= p[i];
+		hash *= 1099511628211ULL;
+	}
+}
+
+//  Floats are hashed as their fixed point value; in deterministic mode
+//  they are all exact fixed point values already.
+//
+uint64_t StateChecksum::compute(const ofApp &app) {
+	const Emitter *emitters[3] = { app.turret, app.enemy, app.enemyT };
+	hash = 14695981039346656037ULL;
+	add(GameClock::tick());
+	add(GameSnapshot::stateToInt(app.game_state));
+	add(app.score);
+	for (int i = 0; i < 3; i++) {
+		const Emitter *e = emitters[i];
+		add(&e->body, sizeof(e->body));
+		add(toFixed(app.health.get(e->healthSlot)));
+		add(e->started);
+		const vector<Sprite> &sprites = e->sys->sprites;
+		add((int32_t)sprites.size());
+		for (int k = 0; k < sprites.size(); k++) {
+			add(toFixed(sprites[k].trans.x));
+			add(toFixed(sprites[k].trans.y));
+			add(toFixed(sprites[k].lifespan));
+		}
+	}
+	last = hash;
+	return hash;
+}
+
+void StateChecksum::record(uint32_t tick, uint64_t sum) {
+	ticks[tick % CHECKSUM_HISTORY] = tick;
+	sums[tick % CHECKSUM_HISTORY] = sum;
+}
+
+//  Checksum recorded for tick, if it is still in the history
+//
+bool StateChecksum::lookup(uint32_t tick, uint64_t &sum) const {
+	if (ticks[tick % CHECKSUM_HISTORY] != tick) return false;
+	sum = sums[tick % CHECKSUM_HISTORY];
+	return true;
+}
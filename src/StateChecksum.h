@@ -0,0 +1,29 @@
+#pragma once
+#include "ofMain.h"
+#include "FixedPoint.h"
+
+class ofApp;
+
+//  FNV-1a hash of the simulation state, taken once per tick in
+//  deterministic mode. Two machines running the same inputs must produce
+//  the same value for the same tick; the first tick where they differ is
+//  where they desynced. Only gameplay state goes in (score, life, emitter
+//  bodies, projectiles), not cosmetic particles.
+//
+#define CHECKSUM_HISTORY 256
+
+class StateChecksum {
+public:
+	StateChecksum();
+	uint64_t compute(const ofApp &app);
+	void record(uint32_t tick, uint64_t sum);
+	bool lookup(uint32_t tick, uint64_t &sum) const;
+
+	uint64_t last;
+private:
+	void add(const void *data, size_t size);
+	void add(int32_t v) { add(&v, sizeof(v)); }
+	uint64_t hash;
+	uint32_t ticks[CHECKSUM_HISTORY];   // ring of recent ticks and their sums
+	uint64_t sums[CHECKSUM_HISTORY];
+};
@@ -0,0 +1,106 @@
+#include "Trajectory.h"
+#include "FixedPoint.h"
+
+// pattern shapes
+//
+static const float parabolaGravity = 200;     // pixels/sec^2
+static const float sineAmplitude = 30;        // pixels
+static const float sineFrequency = TWO_PI * 1.5;
+static const float circleRadius = 40;         // pixels
+static const float circleFrequency = TWO_PI;
+
+Trajectory::Trajectory() {
+	pattern = TrajNone;
+	spawnTime = 0;
+	ox = oy = 0;
+	dx = 0;
+	dy = 1;
+	speed = 0;
+	sinCoef = cosCoef = gravity = freq = 0;
+}
+
+//  Build the path of a projectile fired from origin along velocity
+//
+Trajectory Trajectory::make(TrajectoryPattern pattern, const glm::vec3 &origin, const glm::vec3 &velocity, float speed, float spawnTime) {
+	Trajectory p;
+	ofVec3f dir = ofVec3f(velocity).getNormalized();
+	p.pattern = pattern;
+	p.spawnTime = spawnTime;
+	p.ox = origin.x;
+	p.oy = origin.y;
+	p.dx = dir.x;
+	p.dy = dir.y;
+	p.speed = speed;
+	switch (pattern) {
+	case TrajParabola:
+		p.gravity = parabolaGravity;
+		break;
+	case TrajSine:
+		p.sinCoef = sineAmplitude;
+		p.freq = sineFrequency;
+		break;
+	case TrajCircular:
+		p.sinCoef = circleRadius;
+		p.cosCoef = circleRadius;
+		p.freq = circleFrequency;
+		break;
+	default:
+		break;
+	}
+	return p;
+}
+
+glm::vec3 Trajectory::positionAt(float time) const {
+	float t = (time - spawnTime) / 1000.0;
+	float along = speed * t + cosCoef * (cos(freq * t) - 1);
+	float perp = sinCoef * sin(freq * t);
+	return glm::vec3(ox + dx * along - dy * perp, oy + dy * along + dx * perp + 0.5 * gravity * t * t, 0);
+}
+
+glm::vec3 Trajectory::positionAtFixed(float time) const {
+	fixed16 t = toFixed((time - spawnTime) / 1000.0f);
+	fixed16 ft = fixedMul(toFixed(freq), t);
+	fixed16 along = fixedMul(toFixed(speed), t) + fixedMul(toFixed(cosCoef), fixedCos(ft) - FIXED_ONE);
+	fixed16 perp = fixedMul(toFixed(sinCoef), fixedSin(ft));
+	fixed16 fdx = toFixed(dx), fdy = toFixed(dy);
+	fixed16 x = toFixed(ox) + fixedMul(fdx, along) - fixedMul(fdy, perp);
+	fixed16 y = toFixed(oy) + fixedMul(fdy, along) + fixedMul(fdx, perp) + fixedMul(toFixed(gravity) / 2, fixedMul(t, t));
+	return glm::vec3(toFloat(x), toFloat(y), 0);
+}
+
+void TrajectoryBatch::resize(size_t n) {
+	vector<float> *arrays[] = { &t, &ox, &oy, &dx, &dy, &speed, &sinCoef, &cosCoef, &gravity, &freq, &x, &y };
+	for (int i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++)
+		arrays[i]->resize(n);
+}
+
+void TrajectoryBatch::set(size_t i, const Trajectory &p, float time) {
+	t[i] = (time - p.spawnTime) / 1000.0;
+	ox[i] = p.ox;
+	oy[i] = p.oy;
+	dx[i] = p.dx;
+	dy[i] = p.dy;
+	speed[i] = p.speed;
+	sinCoef[i] = p.sinCoef;
+	cosCoef[i] = p.cosCoef;
+	gravity[i] = p.gravity;
+	freq[i] = p.freq;
+}
+
+//  Same formula as Trajectory::positionAt() over flat arrays so the
+//  compiler can vectorize it.
+//
+void TrajectoryBatch::evaluate() {
+	size_t n = t.size();
+	const float *pt = t.data(), *pox = ox.data(), *poy = oy.data(), *pdx = dx.data(), *pdy = dy.data();
+	const float *pspeed = speed.data(), *psin = sinCoef.data(), *pcos = cosCoef.data(), *pg = gravity.data(), *pf = freq.data();
+	float *px = x.data(), *py = y.data();
+	for (size_t i = 0; i < n; i++) {
+		float ti = pt[i];
+		float a = pf[i] * ti;
+		float along = pspeed[i] * ti + pcos[i] * (cosf(a) - 1);
+		float perp = psin[i] * sinf(a);
+		px[i] = pox[i] + pdx[i] * along - pdy[i] * perp;
+		py[i] = poy[i] + pdy[i] * along + pdx[i] * perp + 0.5f * pg[i] * ti * ti;
+	}
+}
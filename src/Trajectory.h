@@ -0,0 +1,50 @@
+#pragma once
+#include "ofMain.h"
+
+typedef enum { TrajNone, TrajLinear, TrajParabola, TrajSine, TrajCircular, TrajHoming } TrajectoryPattern;
+
+//  Closed form projectile path. A projectile only stores where and when it
+//  was fired and its pattern; its position at any time is
+//
+//     along = speed * t + cosCoef * (cos(freq * t) - 1)
+//     perp  = sinCoef * sin(freq * t)
+//     pos   = origin + dir * along + normal * perp + (0, gravity * t^2 / 2)
+//
+//  with t in seconds since spawnTime. Every pattern is just a different set
+//  of coefficients, so a whole sprite system can be evaluated with one
+//  branch free loop. TrajNone sprites are not moved, TrajHoming sprites are
+//  steered every tick instead.
+//
+//  positionAtFixed() evaluates the same formula in 16.16 fixed point for
+//  the deterministic mode (see GameClock).
+//
+struct Trajectory {
+	TrajectoryPattern pattern;
+	float spawnTime;    // ms
+	float ox, oy;       // origin
+	float dx, dy;       // unit direction of travel
+	float speed;        // pixels/sec
+	float sinCoef;      // pixels
+	float cosCoef;      // pixels
+	float gravity;      // pixels/sec^2, screen down
+	float freq;         // radians/sec
+
+	Trajectory();
+	static Trajectory make(TrajectoryPattern pattern, const glm::vec3 &origin, const glm::vec3 &velocity, float speed, float spawnTime);
+	glm::vec3 positionAt(float time) const;
+	glm::vec3 positionAtFixed(float time) const;
+};
+
+//  Structure of arrays scratch space used to evaluate many trajectories at
+//  once. Buffers are reused between frames.
+//
+class TrajectoryBatch {
+public:
+	void resize(size_t n);
+	void set(size_t i, const Trajectory &p, float time);
+	void evaluate();
+	size_t size() const { return t.size(); }
+
+	vector<float> t, ox, oy, dx, dy, speed, sinCoef, cosCoef, gravity, freq;
+	vector<float> x, y;   // results
+};
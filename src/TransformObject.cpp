@@ -12,3 +12,28 @@ TransformObject::TransformObject() {
 void TransformObject::setPosition(const ofVec3f & pos) {
 	position = pos;
 }
+
+TransformCache::TransformCache() {
+	matrix = glm::mat4(1.0);
+	rotation = 0;
+	scale = glm::vec3(1, 1, 1);
+	rebuilds = 0;
+}
+
+const glm::mat4 &TransformCache::get(const glm::vec3 &t, float r, const glm::vec3 &s) {
+	if (r != rotation || s != scale) {
+		float c = 1, n = 0;
+		if (r != 0) {
+			c = cos(glm::radians(r));
+			n = sin(glm::radians(r));
+		}
+		matrix[0] = glm::vec4(c * s.x, n * s.x, 0, 0);
+		matrix[1] = glm::vec4(-n * s.y, c * s.y, 0, 0);
+		matrix[2] = glm::vec4(0, 0, s.z, 0);
+		rotation = r;
+		scale = s;
+		rebuilds++;
+	}
+	matrix[3] = glm::vec4(t, 1);
+	return matrix;
+}
@@ -4,6 +4,23 @@
 //  Kevin M. Smith - CS 134 SJSU
 //
 
+//  World matrix translate * rotate (degrees about z) * scale, cached. Only
+//  the rotation and scale the linear part was built for are remembered:
+//  while they are unchanged a lookup just writes the translation column,
+//  and objects that never rotate or scale (most projectiles) never do any
+//  trig or matrix products at all.
+//
+class TransformCache {
+public:
+	TransformCache();
+	const glm::mat4 &get(const glm::vec3 &trans, float rotation, const glm::vec3 &scale);
+	int rebuilds;          // times the linear part was recomputed
+private:
+	glm::mat4 matrix;
+	float rotation;        // what the linear part of matrix was built for
+	glm::vec3 scale;
+};
+
 //  Base class for any object that needs a transform.
 //
 class TransformObject {
@@ -13,4 +30,6 @@ public:
 	float	rotation;
 	bool	bSelected;
 	void setPosition(const ofVec3f &);
+	const glm::mat4 &getMatrix() const { return transform.get(position, rotation, scale); }
+	mutable TransformCache transform;
 };
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "VecMath.h"
+
+//  Store the indices of the points at most radius from p in out, in
+//  increasing order, and return how many there are. out needs room for n.
+//
+int withinRadius(const float *x, const float *y, int n, const float2 &p, float radius, int *out) {
+	float4 px = float4::splat(p.x), py = float4::splat(p.y);
+	float r2 = radius * radius;
+	float4 limit = float4::splat(r2);
+	int count = 0;
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		float4 dx = float4::load(x + i) - px;
+		float4 dy = float4::load(y + i) - py;
+		int hits = (dx * dx + dy * dy).lessEqual(limit).mask();
+		for (; hits; hits &= hits - 1) {
+			int lane = 0;
+			while (!(hits & (1 << lane))) lane++;
+			out[count++] = i + lane;
+		}
+	}
+	for (; i < n; i++) {
+		float dx = x[i] - p.x, dy = y[i] - p.y;
+		if (dx * dx + dy * dy <= r2) out[count++] = i;
+	}
+	return count;
+}
+
+//  (outX[i], outY[i]) = m applied to (x[i], y[i]); out may alias the input
+//
+void transformMany(const float2x3 &m, const float *x, const float *y, int n, float *outX, float *outY) {
+	float4 a = float4::splat(m.a), b = float4::splat(m.b), tx = float4::splat(m.tx);
+	float4 c = float4::splat(m.c), d = float4::splat(m.d), ty = float4::splat(m.ty);
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		float4 vx = float4::load(x + i);
+		float4 vy = float4::load(y + i);
+		(a * vx + b * vy + tx).store(outX + i);
+		(c * vx + d * vy + ty).store(outY + i);
+	}
+	for (; i < n; i++) {
+		float px = x[i], py = y[i];
+		outX[i] = m.a * px + m.b * py + m.tx;
+		outY[i] = m.c * px + m.d * py + m.ty;
+	}
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include "ofMain.h"
+
+//  2D math for the hot loops. The game is flat, so positions and
+//  velocities only need x and y:
+//
+//     float2    one point or vector, converts from glm::vec3 and ofVec3f
+//     float2x3  2D affine transform (the xy part of a glm::mat4)
+//     float4    four floats in one SIMD register
+//
+//  The batch functions below work on structure of arrays data (separate x
+//  and y arrays) four elements at a time with SSE2 on x86 and NEON on
+//  64 bit ARM, and fall back to plain loops elsewhere. They only add,
+//  subtract and multiply, so the SIMD lanes and the scalar remainder agree
+//  bit for bit as long as the compiler is not told to fuse multiply-adds.
+//
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VECMATH_SSE
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define VECMATH_NEON
+#endif
+
+struct float2 {
+	float x, y;
+	float2() : x(0), y(0) {}
+	float2(float x, float y) : x(x), y(y) {}
+	explicit float2(const glm::vec3 &v) : x(v.x), y(v.y) {}
+	explicit float2(const ofVec3f &v) : x(v.x), y(v.y) {}
+	glm::vec3 vec3() const { return glm::vec3(x, y, 0); }
+
+	float2 operator+(const float2 &o) const { return float2(x + o.x, y + o.y); }
+	float2 operator-(const float2 &o) const { return float2(x - o.x, y - o.y); }
+	float2 operator*(float s) const { return float2(x * s, y * s); }
+	float2 &operator+=(const float2 &o) { x += o.x; y += o.y; return *this; }
+	float dot(const float2 &o) const { return x * o.x + y * o.y; }
+	float lengthSquared() const { return x * x + y * y; }
+	float distanceSquared(const float2 &o) const { return (*this - o).lengthSquared(); }
+};
+
+struct float2x3 {
+	float a, b, tx;    // x' = a x + b y + tx
+	float c, d, ty;    // y' = c x + d y + ty
+	static float2x3 fromMat4(const glm::mat4 &m) {
+		float2x3 t = { m[0][0], m[1][0], m[3][0], m[0][1], m[1][1], m[3][1] };
+		return t;
+	}
+	float2 apply(const float2 &p) const { return float2(a * p.x + b * p.y + tx, c * p.x + d * p.y + ty); }
+};
+
+struct float4 {
+#if defined(VECMATH_SSE)
+	__m128 v;
+	static float4 load(const float *p) { float4 r; r.v = _mm_loadu_ps(p); return r; }
+	static float4 splat(float s) { float4 r; r.v = _mm_set1_ps(s); return r; }
+	void store(float *p) const { _mm_storeu_ps(p, v); }
+	float4 operator+(const float4 &o) const { float4 r; r.v = _mm_add_ps(v, o.v); return r; }
+	float4 operator-(const float4 &o) const { float4 r; r.v = _mm_sub_ps(v, o.v); return r; }
+	float4 operator*(const float4 &o) const { float4 r; r.v = _mm_mul_ps(v, o.v); return r; }
+	float4 lessEqual(const float4 &o) const { float4 r; r.v = _mm_cmple_ps(v, o.v); return r; }
+	int mask() const { return _mm_movemask_ps(v); }
+#elif defined(VECMATH_NEON)
+	float32x4_t v;
+	static float4 load(const float *p) { float4 r; r.v = vld1q_f32(p); return r; }
+	static float4 splat(float s) { float4 r; r.v = vdupq_n_f32(s); return r; }
+	void store(float *p) const { vst1q_f32(p, v); }
+	float4 operator+(const float4 &o) const { float4 r; r.v = vaddq_f32(v, o.v); return r; }
+	float4 operator-(const float4 &o) const { float4 r; r.v = vsubq_f32(v, o.v); return r; }
+	float4 operator*(const float4 &o) const { float4 r; r.v = vmulq_f32(v, o.v); return r; }
+	float4 lessEqual(const float4 &o) const { float4 r; r.v = vreinterpretq_f32_u32(vcleq_f32(v, o.v)); return r; }
+	int mask() const {
+		static const uint32_t bits[4] = { 1, 2, 4, 8 };
+		return vaddvq_u32(vandq_u32(vreinterpretq_u32_f32(v), vld1q_u32(bits)));
+	}
+#else
+	//lanes of a comparison hold all bits set (true) or zero
+	float v[4];
+	static float4 load(const float *p) { float4 r; memcpy(r.v, p, sizeof(r.v)); return r; }
+	static float4 splat(float s) { float4 r; r.v[0] = r.v[1] = r.v[2] = r.v[3] = s; return r; }
+	void store(float *p) const { memcpy(p, v, sizeof(v)); }
+	float4 operator+(const float4 &o) const { float4 r; for (int i = 0; i < 4; i++) r.v[i] = v[i] + o.v[i]; return r; }
+	float4 operator-(const float4 &o) const { float4 r; for (int i = 0; i < 4; i++) r.v[i] = v[i] - o.v[i]; return r; }
+	float4 operator*(const float4 &o) const { float4 r; for (int i = 0; i < 4; i++) r.v[i] = v[i] * o.v[i]; return r; }
+	float4 lessEqual(const float4 &o) const { float4 r; for (int i = 0; i < 4; i++) r.setLane(i, v[i] <= o.v[i]); return r; }
+	int mask() const {
+		int m = 0;
+		for (int i = 0; i < 4; i++) {
+			uint32_t bits;
+			memcpy(&bits, &v[i], 4);
+			if (bits) m |= 1 << i;
+		}
+		return m;
+	}
+	void setLane(int i, bool on) {
+		uint32_t bits = on ? 0xffffffff : 0;
+		memcpy(&v[i], &bits, 4);
+	}
+#endif
+};
+
+//  Batch operations on n points given as x and y arrays
+//
+int withinRadius(const float *x, const float *y, int n, const float2 &p, float radius, int *out);
+void transformMany(const float2x3 &m, const float *x, const float *y, int n, float *outX, float *outY);
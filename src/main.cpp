@@ -1,13 +1,62 @@
 #include "ofMain.h"
+#include "ofAppNoWindow.h"
 #include "ofApp.h"
 
 //========================================================================
-int main( ){
-	ofSetupOpenGL(1334,750,OF_WINDOW);			// <-------- setup the GL context
+int main(int argc, char *argv[]){
+	ofApp *app = new ofApp();
+
+	// --software     run without a window and rasterize frames on the CPU
+	// --dump-frames  with --software, write every frame to data/frames/
+	// --build-pack   decode the game's images into data/assets.pack and exit
+	// --metrics FILE write prometheus metrics to data/FILE every second
+	// --threaded     run the simulation on its own thread
+	// --deterministic  fixed 60 Hz clock, fixed point physics, per tick checksums
+	// --peer HOST:PORT two player lockstep with the game at HOST:PORT (implies --deterministic)
+	// --port PORT    local udp port for lockstep, default 7000
+	// --player N     0 plays the turret (default), 1 the right enemy
+	// --net-loss F   drop this fraction of outgoing lockstep packets
+	// --net-delay MS hold outgoing lockstep packets this long
+	// --bot SCENARIO headless stress run with the turret played by a bot
+	//                (normal, busy, swarm, flood)
+	// --bot-minutes N  end the bot run after N minutes
+	// --alloc-limit N  count gameplay frames with more than N heap allocations
+	//                as failures (a bot run then exits with status 1)
+	// --barrels N    give the turret N guns
+	//
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "--software") app->softwareRender = true;
+		else if (arg == "--dump-frames") app->dumpFrames = true;
+		else if (arg == "--build-pack") app->buildPack = true;
+		else if (arg == "--threaded") app->threadedSim = true;
+		else if (arg == "--deterministic") app->deterministic = true;
+		else if (arg == "--metrics" && i + 1 < argc) app->metricsPath = argv[++i];
+		else if (arg == "--peer" && i + 1 < argc) app->netPeer = argv[++i];
+		else if (arg == "--port" && i + 1 < argc) app->netPort = atoi(argv[++i]);
+		else if (arg == "--player" && i + 1 < argc) app->netPlayer = atoi(argv[++i]);
+		else if (arg == "--net-loss" && i + 1 < argc) app->lockstep.loss = atof(argv[++i]);
+		else if (arg == "--net-delay" && i + 1 < argc) app->lockstep.delay = atof(argv[++i]);
+		else if (arg == "--bot" && i + 1 < argc) {
+			app->botScenario = argv[++i];
+			app->softwareRender = true;
+		}
+		else if (arg == "--bot-minutes" && i + 1 < argc) app->botMinutes = atof(argv[++i]);
+		else if (arg == "--alloc-limit" && i + 1 < argc) app->allocLimit = atoi(argv[++i]);
+		else if (arg == "--barrels" && i + 1 < argc) app->barrels = atoi(argv[++i]);
+	}
+
+	if (app->softwareRender || app->buildPack) {
+		// no GL context; the no-window loop still calls update() and draw()
+		ofSetupOpenGL(std::make_shared<ofAppNoWindow>(), PLAYFIELD_WIDTH, PLAYFIELD_HEIGHT, OF_WINDOW);
+	}
+	else {
+		ofSetupOpenGL(PLAYFIELD_WIDTH, PLAYFIELD_HEIGHT, OF_WINDOW);			// <-------- setup the GL context
+	}
 
 	// this kicks off the running of my app
 	// can be OF_WINDOW or OF_FULLSCREEN
 	// pass in width and height too:
-	ofRunApp(new ofApp());
+	ofRunApp(app);
 
 }
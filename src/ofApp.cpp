@@ -54,7 +54,7 @@ Sprite::Sprite() {
 // Return a sprite's age in milliseconds
 //
 float Sprite::age() {
-	return (ofGetElapsedTimeMillis() - birthtime);
+	return (GameClock::millis() - birthtime);
 }
 
 /*void Sprite::update() {
@@ -77,22 +77,17 @@ void Sprite::setImage(ofImage img) {
 //
 void Sprite::draw() {
 
-	//ofSetColor(255, 255, 255, 255);
-	ofPushMatrix();
-	
+	RenderBackend *render = RenderBackend::get();
+
 	// draw image centered and add in translation amount
 	//
 	if (haveImage) {
-		ofMultMatrix(getMatrix());
-		image.draw(-width / 2.0 , -height / 2.0 );
-		ofPopMatrix();
-		
+		render->drawImage(image, getMatrix(), -width / 2.0, -height / 2.0);
 	}
 	else {
 		// in case no image is supplied, draw something.
 		// 
-		//ofSetColor(255, 0, 0);
-		ofDrawRectangle(-width / 2.0 + trans.x, -height / 2.0 + trans.y, width, height);
+		render->drawRectangle(-width / 2.0 + trans.x, -height / 2.0 + trans.y, width, height);
 	}
 	
 }
@@ -102,6 +97,7 @@ void Sprite::draw() {
 //  Add a Sprite to the Sprite System
 //
 void SpriteSystem::add(Sprite s) {
+	MemoryScope scope(MemSprites);
 	sprites.push_back(s);
 }
 
@@ -111,6 +107,12 @@ void SpriteSystem::add(Sprite s) {
 //
 void SpriteSystem::remove(int i) {
 	sprites.erase(sprites.begin() + i);
+	alive.clear();
+}
+
+void SpriteSystem::clear() {
+	sprites.clear();
+	alive.clear();
 }
 
 
@@ -118,36 +120,55 @@ void SpriteSystem::remove(int i) {
 
 
 //  Update the SpriteSystem by checking which sprites have exceeded their
-//  lifespan (and deleting).  Also the sprite is moved to it's next
+//  lifespan and removing them, together with the ones killed since the
+//  last update, in one pass. Also the sprite is moved to it's next
 //  location based on velocity and direction.
 //
 void SpriteSystem::update() {
 	if (sprites.size() == 0) return;
-	vector<Sprite>::iterator s = sprites.begin();
-	vector<Sprite>::iterator tmp;
 
-	// check which sprites have exceed their lifespan and delete
-	// from list.  When deleting multiple objects from a vector while
-	// traversing at the same time, use an iterator.
-	//
-	while (s != sprites.end()) {
-		if (s->lifespan != -1 && s->age() > s->lifespan) {
-			//			cout << "deleting sprite: " << s->name << endl;
-			tmp = sprites.erase(s);
-			s = tmp;
-		}
-		else s++;
+	for (int i = 0; i < sprites.size(); i++) {
+		if (sprites[i].lifespan != -1 && sprites[i].age() > sprites[i].lifespan) kill(i);
 	}
+	reap();
 
-	//  Move sprite
+	//  Move sprites that don't follow a trajectory
 	//
 	for (int i = 0; i < sprites.size(); i++) {
+		if (sprites[i].path.pattern != TrajNone) continue;
 		sprites[i].trans += sprites[i].velocity.getNormalized()*100 / ofGetFrameRate();
 		
 		
 	}
 }
 
+//  Move every sprite that follows a closed form trajectory to where it is
+//  at "time". The paths are gathered into the batch, evaluated in one pass
+//  and written back. Homing sprites are steered separately.
+//
+void SpriteSystem::evaluateTrajectories(float time) {
+	MemoryScope scope(MemSprites);
+	moving.clear();
+	for (int i = 0; i < sprites.size(); i++) {
+		TrajectoryPattern pattern = sprites[i].path.pattern;
+		if (pattern != TrajNone && pattern != TrajHoming)
+			moving.push_back(i);
+	}
+
+	if (GameClock::isFixed()) {
+		for (int k = 0; k < moving.size(); k++)
+			sprites[moving[k]].trans = sprites[moving[k]].path.positionAtFixed(time);
+		return;
+	}
+
+	batch.resize(moving.size());
+	for (int k = 0; k < moving.size(); k++)
+		batch.set(k, sprites[moving[k]].path, time);
+	batch.evaluate();
+	for (int k = 0; k < moving.size(); k++)
+		sprites[moving[k]].trans = glm::vec3(batch.x[k], batch.y[k], 0);
+}
+
 //  Render all the sprites
 //
 void SpriteSystem::draw() {
@@ -173,6 +194,8 @@ Emitter::Emitter(SpriteSystem *spriteSys) {
 	height = 150;
 	childWidth = 10;
 	childHeight = 10;
+	shape = CollisionShape::circle(height / 2);
+	childShape = CollisionShape::circle(childHeight / 2);
 }
 
 //  Draw the Emitter if it is drawable. In many cases you would want a hidden emitter
@@ -180,22 +203,9 @@ Emitter::Emitter(SpriteSystem *spriteSys) {
 //
 void Emitter::draw() {
 	
-	
-	ofPushMatrix();
-	
-
-	if (drawable) {
-
-		if (haveImage) {
-			ofMultMatrix(getMatrix());
-			image.draw(-image.getWidth() / 2.0 , -image.getHeight() / 2.0 );
-			
-
-
-		}
+	if (drawable && haveImage) {
+		RenderBackend::get()->drawImage(image, getMatrix(), -image.getWidth() / 2.0, -image.getHeight() / 2.0);
 	}
-
-	ofPopMatrix();
 	
 	// draw sprite system
 	//
@@ -214,7 +224,7 @@ void Emitter::setupSpeed(float _speed) {
 //
 void Emitter::update() {
 	if (!started) return;
-	float time = ofGetElapsedTimeMillis();
+	float time = GameClock::millis();
 	/*if ((time - lastSpawned) > (1000.0 / rate)) {
 		// spawn a new sprite
 		Sprite sprite;
@@ -241,7 +251,7 @@ void Emitter::update() {
 //
 void Emitter::start() {
 	started = true;
-	lastSpawned = ofGetElapsedTimeMillis();
+	lastSpawned = GameClock::millis();
 }
 
 void Emitter::stop() {
@@ -272,6 +282,10 @@ void Emitter::setRate(float r) {
 }
 
 void Emitter::integrate() {
+	if (GameClock::isFixed()) {
+		integrateFixed();
+		return;
+	}
 
 	float dt = 1.0 / 60.0;
 	trans += vel * dt;
@@ -284,69 +298,146 @@ void Emitter::integrate() {
 	angularAcceleration = (1 / mass) * angularForce;
 }
 
-
-
-void Emitter::move() {
-	//make the enemy sprites move parabola path
-	for (int i = 0; i < sys->sprites.size(); i++) {
-		sys->sprites[i].velocity.x += sin(sys->sprites[i].velocity.y);
-		sys->sprites[i].velocity.y += 1;
-		
-		
-	}
+//  Anything outside the physics may have moved the emitter since the last
+//  step (clamping to the window, a crash, a snapshot restore), so a float
+//  that no longer matches its fixed point value is taken as the new value.
+//
+static void syncFixed(fixed16 &f, float v) {
+	if (toFloat(f) != v) f = toFixed(v);
 }
 
-void Emitter::sine() {
-	//make the enemy sprites move sinusoidal path
-	for (int i = 0; i < sys->sprites.size(); i++) {
-		sys->sprites[i].trans.x += sin(ofGetElapsedTimef())/5;
-		sys->sprites[i].trans.y += cos(ofGetElapsedTimef())/5;
-
-	}
-	
+//  integrate() in 16.16 fixed point. Forces are converted once on the way
+//  in, everything after that is integer math, and the results are written
+//  back to the floats the rest of the game reads.
+//
+void Emitter::integrateFixed() {
+	syncFixed(body.x, trans.x);
+	syncFixed(body.y, trans.y);
+	syncFixed(body.vx, vel.x);
+	syncFixed(body.vy, vel.y);
+	syncFixed(body.ax, acceleration.x);
+	syncFixed(body.ay, acceleration.y);
+	syncFixed(body.rotation, rotation);
+	syncFixed(body.angularVelocity, angularVelocity);
+	syncFixed(body.angularAcceleration, angularAcceleration);
+
+	fixed16 dt = FIXED_ONE / 60;
+	fixed16 damp = toFixed(damping);
+	fixed16 invMass = fixedDiv(FIXED_ONE, toFixed(mass));
+	body.x += fixedMul(body.vx, dt);
+	body.y += fixedMul(body.vy, dt);
+	body.vx = fixedMul(body.vx + fixedMul(body.ax, dt), damp);
+	body.vy = fixedMul(body.vy + fixedMul(body.ay, dt), damp);
+	body.ax = fixedMul(toFixed(force.x), invMass);
+	body.ay = fixedMul(toFixed(force.y), invMass);
+	body.angularVelocity = fixedMul(body.angularVelocity + fixedMul(body.angularAcceleration, dt), damp);
+	body.rotation = (body.rotation + fixedMul(body.angularVelocity, dt)) % (360 * FIXED_ONE);
+	if (body.rotation < 0) body.rotation += 360 * FIXED_ONE;
+	body.angularAcceleration = fixedMul(toFixed(angularForce), invMass);
+
+	trans = glm::vec3(toFloat(body.x), toFloat(body.y), 0);
+	vel = ofVec3f(toFloat(body.vx), toFloat(body.vy), 0);
+	acceleration = ofVec3f(toFloat(body.ax), toFloat(body.ay), 0);
+	rotation = toFloat(body.rotation);
+	angularVelocity = toFloat(body.angularVelocity);
+	angularAcceleration = toFloat(body.angularAcceleration);
 }
 
 
 
+// SpriteSystem::update() used to push every sprite 100 pixels/sec along its
+// velocity on top of the firing speed; projectiles keep that overall speed
+// now that they follow trajectories.
+//
+static const float spriteDrift = 100;
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+//  Every image the game loads. --build-pack decodes exactly these into
+//  data/assets.pack; anything not listed is left out of the pack.
+//
+static const char *packedImages[] = {
+	"images/startScreen.png",
+	"images/background1.png",
+	"images/endScreen.png",
+	"images/bullet.png",
+	"images/target.png",
+	"images/inv.png",
+	"images/player.png",
+};
+
+//  Load an image from the asset pack, falling back to decoding the file
+//
+bool ofApp::loadImage(ofImage &img, const string &name) {
+	MemoryScope scope(MemAssets);
+	if (assets.loadImage(img, name)) return true;
+	return img.load(name);
+}
 
 //--------------------------------------------------------------
 void ofApp::setup() {
 	game_state = "start";
 	ofSetVerticalSync(true);
-	bgm.load("sound/bgm.mpeg");
-	gg.load("sound/gg.mp3");
-	w.load("sound/win.mp3");
-	start_screen.load("images/startScreen.png");
-	background.load("images/background1.png");
-	bullet.load("sound/firing.mp3");
-	bulletImage.load("images/bullet.png");
-	targetImage.load("images/target.png");
-	invaderImage.load("images/inv.png");
-	explode.load("sound/explode.mp3");
-	font.load("font/Marlboro.ttf", 30);
-	end_screen.load("images/endScreen.png");
-	if (turretImage.load("images/player.png")) {
+
+	if (buildPack) {
+		vector<string> names(packedImages, packedImages + sizeof(packedImages) / sizeof(packedImages[0]));
+		ofExit(AssetPack::build(names, "assets.pack") ? 0 : 1);
+		return;
+	}
+	assets.open("assets.pack");
+	setupMetrics();
+
+	//lockstep needs both sides to simulate identically
+	if (!netPeer.empty()) {
+		deterministic = true;
+		if (!lockstep.setup(netPlayer, netPort, netPeer)) {
+			cout << "lockstep: could not start, exiting" << endl;
+			ofExit(1);
+			return;
+		}
+	}
+
+	//with --deterministic the game runs on a fixed 60 Hz clock
+	if (deterministic) GameClock::setFixedStep(1000.0 / 60);
+	setupEvents();
+	scheduler.events = &events;
+
+	//without a GPU draw into a CPU frame buffer and keep images off the GPU
+	if (softwareRender) {
+		softRenderer.allocate(ofGetWindowWidth(), ofGetWindowHeight());
+		if (dumpFrames && !ofDirectory::createDirectory("frames", true, true)) {
+			cout << "can't create data/frames, not dumping frames" << endl;
+			dumpFrames = false;
+		}
+		softRenderer.dumpFrames = dumpFrames;
+		RenderBackend::set(&softRenderer);
+		ofImage *images[] = { &start_screen, &background, &bulletImage, &targetImage, &invaderImage, &end_screen, &turretImage };
+		for (int i = 0; i < sizeof(images) / sizeof(images[0]); i++)
+			images[i]->setUseTexture(false);
+	}
+
+	//music streams, effects stay resident; no audio device when headless
+	if (softwareRender) GameSound::setNullDevice(true);
+	bgm.load("sound/bgm.mpeg", SoundMusic);
+	gg.load("sound/gg.mp3", SoundMusic);
+	w.load("sound/win.mp3", SoundMusic);
+	loadImage(start_screen, "images/startScreen.png");
+	loadImage(background, "images/background1.png");
+	bullet.load("sound/firing.mp3", SoundEffect);
+	loadImage(bulletImage, "images/bullet.png");
+	loadImage(targetImage, "images/target.png");
+	loadImage(invaderImage, "images/inv.png");
+	explode.load("sound/explode.mp3", SoundEffect);
+	if (!softwareRender) {
+		MemoryScope scope(MemAssets);
+		font.load("font/Marlboro.ttf", 30);
+	}
+	scoreHud.setup(&font, "Score: ");
+	lifeHud.setup(&font, "Life: ");
+	gameOverHud.setup(&font, "");
+	gameOverHud.setText("GAME OVER");
+	winHud.setup(&font, "");
+	winHud.setText("CONGRATS! YOU WIN");
+	loadImage(end_screen, "images/endScreen.png");
+	if (loadImage(turretImage, "images/player.png")) {
 		imageLoaded = true;
 	}
 	else {
@@ -354,6 +445,12 @@ void ofApp::setup() {
 		ofExit();
 	}
 
+	//full window images are scaled to the window once, not every frame
+	startLayer = compositor.addStaticLayer(&start_screen);
+	backgroundLayer = compositor.addStaticLayer(&background);
+	endLayer = compositor.addStaticLayer(&end_screen);
+	compositor.resize(ofGetWindowWidth(), ofGetWindowHeight());
+
 	score = 0;
 
 
@@ -381,28 +478,34 @@ void ofApp::setup() {
 		turret->mass = 1.0;
 		turret->force = ofVec3f(0, 0, 0);
 
-		enemy->trans = ofVec3f(ofGetWindowWidth() / 4, ofGetWindowHeight() / 2, 0);
+		enemy->trans = ofVec3f(playWidth() / 4, playHeight() / 2, 0);
 		//enemy->trans = ofVec3f(100, ofGetWindowHeight() / 2, 0);
-		enemyT->trans = ofVec3f(ofGetWindowWidth() - 100, ofGetWindowHeight() / 2, 0);
+		enemyT->trans = ofVec3f(playWidth() - 100, playHeight() / 2, 0);
 
 		enemy->mass = 2.0;
 		enemyT->mass = 2.0;
 
-		turret->setLifespan(100);
+		//hit points; a sprite's lifespan is only its time to live
+		health.clear();
+		turret->healthSlot = health.add(100);
+		enemy->healthSlot = health.add(500);
+		enemyT->healthSlot = health.add(500);
 
 		enemy->rate = 3;
 		enemyT->rate = 3;
 
-		enemy->lifespan = 500;
-		enemyT->lifespan = 500;
-
-		turret->setPosition(ofVec3f(ofGetWindowWidth() / 2.0, ofGetWindowHeight() / 2.0, 0));
-		turret->trans = (ofVec3f(ofGetWindowWidth() / 2.0, ofGetWindowHeight() / 2.0, 0));
+		turret->setPosition(ofVec3f(playWidth() / 2.0, playHeight() / 2.0, 0));
+		turret->trans = (ofVec3f(playWidth() / 2.0, playHeight() / 2.0, 0));
 		turret->head = glm::vec3(0, -1, 0);
 		turret->left = glm::vec3(1, 0, 0);
 
 		turret->setChildImage(bulletImage);
 
+		//hitboxes: the ships are traced from their images, shots stay round
+		turret->shape.setFromImage(turretImage);
+		enemy->shape.setFromImage(invaderImage);
+		enemyT->shape = enemy->shape;
+
 
 		
 
@@ -412,29 +515,36 @@ void ofApp::setup() {
 		turret->setupSpeed(3);
 
 		//set up guis, including sliders and toggles
-		gui.setup();
-		gui.add(rate.setup("rate", 7, 7, 20));
-	//	gui.add(lifespan.setup("player lifespan",10,5,100));
-		//gui.add(lifespan.setup("life", -1, .1, 10));
-		gui.add(speed.setup("speed", 3, .1, 10));
-		//gui.add(velocity.setup("velocity", glm::vec3(0, 0, 0), ofVec3f(-1000, -1000, 0), ofVec3f(1000, 1000, 0)));
-
-		gui.add(leftEnemyFiringSpeed.setup("left enemy fire speed", 50, 10, 500));
-
-		gui.add(leftEnemyRate.setup("left enemy rate", 3, 0, 10));
-		gui.add(leftEnemyLife.setup("left enemy lifespan", 10, .1, 10));
-		//gui.add(leftEnemyVelocity.setup("left enemy velocity", glm::vec3(0, 200, 0), ofVec3f(-1000, -1000, 0), ofVec3f(1000, 1000, 0)));
-
-
-		gui.add(rightEnemyFiringSpeed.setup("right enemy fire speed", 50, 10, 500));
-
-		gui.add(rightEnemyRate.setup("right enemy rate", 3, 0, 10));
-		gui.add(rightEnemyLife.setup("right enemy lifespan", 10, .1, 10));
-		//gui.add(rightEnemyVelocity.setup("right enemy velocity", glm::vec3(0, 200, 0), ofVec3f(-1000, -1000, 0), ofVec3f(1000, 1000, 0)));
-
-		gui.add(parabola.setup("parabola", false));
-		gui.add(sine.setup("sine", false));
-		gui.add(circle.setup("apply circular force", false));
+		{
+			MemoryScope uiScope(MemUI);
+			gui.setup();
+			gui.add(rate.setup("rate", 7, 7, 20));
+		//	gui.add(lifespan.setup("player lifespan",10,5,100));
+			//gui.add(lifespan.setup("life", -1, .1, 10));
+			gui.add(speed.setup("speed", 3, .1, 10));
+			//gui.add(velocity.setup("velocity", glm::vec3(0, 0, 0), ofVec3f(-1000, -1000, 0), ofVec3f(1000, 1000, 0)));
+
+			gui.add(leftEnemyFiringSpeed.setup("left enemy fire speed", 50, 10, 500));
+
+			gui.add(leftEnemyRate.setup("left enemy rate", 3, 0, 10));
+			gui.add(leftEnemyLife.setup("left enemy lifespan", 10, .1, 10));
+			//gui.add(leftEnemyVelocity.setup("left enemy velocity", glm::vec3(0, 200, 0), ofVec3f(-1000, -1000, 0), ofVec3f(1000, 1000, 0)));
+
+
+			gui.add(rightEnemyFiringSpeed.setup("right enemy fire speed", 50, 10, 500));
+
+			gui.add(rightEnemyRate.setup("right enemy rate", 3, 0, 10));
+			gui.add(rightEnemyLife.setup("right enemy lifespan", 10, .1, 10));
+			//gui.add(rightEnemyVelocity.setup("right enemy velocity", glm::vec3(0, 200, 0), ofVec3f(-1000, -1000, 0), ofVec3f(1000, 1000, 0)));
+
+			gui.add(parabola.setup("parabola", false));
+			gui.add(sine.setup("sine", false));
+			gui.add(circle.setup("apply circular force", false));
+			gui.add(homing.setup("homing shots", false));
+			gui.add(qualityLabel.setup("effect quality", ""));
+			for (int t = 0; t < MEMORY_TAGS; t++)
+				gui.add(memoryLabels[t].setup(string(MemoryTracker::name(t)) + " MB", ""));
+		}
 
 
 		//initailize the enemy sprite velocity
@@ -453,23 +563,239 @@ void ofApp::setup() {
 		explosion.setVelocity(ofVec3f(200, 200, 0));
 		explosion.setOneShot(true);
 		explosion.setEmitterType(RadialEmitter);
-		explosion.setGroupSize(20);
+		explosion.setGroupSize(explosionGroupSize);
 		explosion.setParticleRadius(5);
 		explosion.setLifespan(1);
-		explosion.setPosition(ofVec2f(ofGetWindowWidth() / 2, ofGetWindowHeight() / 2));
-
-	
+		explosion.setPosition(ofVec2f(playWidth() / 2, playHeight() / 2));
+
+		//explosions flash white, burn through orange and fade out in red
+		explosionCurve.addColorKey(0, ofColor(255, 255, 210));
+		explosionCurve.addColorKey(0.2, ofColor(255, 170, 40));
+		explosionCurve.addColorKey(0.6, ofColor(210, 50, 20, 200));
+		explosionCurve.addColorKey(1, ofColor(80, 20, 20, 0));
+		explosionCurve.addSizeKey(0, 0.8);
+		explosionCurve.addSizeKey(0.25, 1.4);
+		explosionCurve.addSizeKey(1, 0.4);
+		explosionCurve.bake();
+		explosion.sys->curve = &explosionCurve;
+
+		//spawn timeline for the enemy shots and the player's bullets
+		double now = GameClock::millis();
+		leftWave = scheduler.addWave(enemy, &targetImage, enemy->rate, now);
+		rightWave = scheduler.addWave(enemyT, &targetImage, enemyT->rate, now);
+		turretWave = scheduler.addWave(turret, &bulletImage, turret->rate, now);
+		scheduler.waves[turretWave].aim = AimEmitterHead;
+		scheduler.waves[turretWave].speed = 400 + spriteDrift;
+		scheduler.waves[turretWave].lifespan = 2000;
+		scheduler.waves[turretWave].enabled = false;
+
+		//the turret's barrels hang off it in the scene graph, each one
+		//turned a little further out; one barrel fires from the center
+		scene.clear();
+		turretNode = scene.add(-1, float2());
+		scene.bind(turretNode, turret);
+		leftNode = scene.add(-1, float2());
+		scene.bind(leftNode, enemy);
+		rightNode = scene.add(-1, float2());
+		scene.bind(rightNode, enemyT);
+		if (barrels > 1) {
+			scheduler.waves[turretWave].firstNode = scene.size();
+			scheduler.waves[turretWave].nodes = barrels;
+			for (int b = 0; b < barrels; b++) {
+				float side = b - (barrels - 1) / 2.0;
+				scene.add(turretNode, float2(side * 8, -turret->childHeight), side * 6);
+			}
+		}
+		scheduler.scene = &scene;
+
+		//stress runs: the bot plays the turret and loads the enemies up; a
+		//bad scenario name would leave a windowless run nobody plays
+		if (!botScenario.empty() && !bot.setup(*this, botScenario, botMinutes)) ofExit(1);
+
+		//draw() always has a snapshot to show, even before the first step
+		renderBuffer.writeBuffer().capture(*this);
+		renderBuffer.publish();
+
+		//with --threaded the game steps on its own thread; sounds it
+		//triggers are played from update()
+		if (threadedSim) {
+			GameSound::setDeferred(true);
+			simThread.setup(this, 60);
+			simThread.startThread();
+		}
 
 }
 
 //--------------------------------------------------------------
 void ofApp::update() {
+	if (buildPack) return;   //setup() only wrote the pack, nothing is set up
+	checkAllocations();
+
+	//sounds requested by the simulation thread are started here
+	GameSound *sounds[] = { &bgm, &gg, &w, &bullet, &explode };
+	for (int i = 0; i < sizeof(sounds) / sizeof(sounds[0]); i++)
+		sounds[i]->service();
+
+	if (bot.active) bot.update(*this);
+	if (!threadedSim) simulate();
+
+	//gui labels
+	MemoryScope uiScope(MemUI);
+
+	//only touch the label when the values change
+	int level = budget.level, throttles = budget.throttleCount;
+	if (level != shownLevel || throttles != shownThrottles) {
+		shownLevel = level;
+		shownThrottles = throttles;
+		qualityLabel = ofToString(shownLevel) + "/" + ofToString(EFFECT_LEVELS - 1) + " throttled " + ofToString(shownThrottles);
+	}
+
+	//memory in use/peak and allocations in the last frame, while the
+	//panel is shown
+	float now = ofGetElapsedTimeMillis();
+	if (!bHide && now >= nextMemoryLabel) {
+		nextMemoryLabel = now + 500;
+		for (int t = 0; t < MEMORY_TAGS; t++)
+			memoryLabels[t] = ofToString(MemoryTracker::current(t) / 1048576.0, 1) + "/" + ofToString(MemoryTracker::peak(t) / 1048576.0, 1)
+				+ ", " + ofToString(MemoryTracker::frameAllocations(t)) + "/frame";
+	}
+}
+
+//  One step of the game. Runs from update(), or on simThread with
+//  --threaded; either way it ends by publishing what draw() should show.
+//
+void ofApp::simulate() {
+	std::lock_guard<std::mutex> lock(simMutex);
+	budget.beginUpdate();
+
+	if (lockstep.isActive()) stepLockstep();
+	else stepGame();
+
+	budget.endUpdate();
+	budget.adjust();
+	recordMetrics();
+
+	RenderSnapshot &frame = renderBuffer.writeBuffer();
+	frame.capture(*this);
+	frame.step = simSteps++;
+	renderBuffer.publish();
+}
+
+//  Lockstep ticks run on the 60 Hz clock from the moment the peer is first
+//  heard from, as far ahead of it as the window allows. A late peer input
+//  that differs from its prediction rewinds the game to the tick before it
+//  and replays up to the current tick with sounds muted.
+//
+#define LOCKSTEP_CATCHUP 4   // most ticks run per call when behind
+
+void ofApp::stepLockstep() {
+	float now = ofGetElapsedTimeMillis();
+	lockstep.poll(now);
+	if (lockstepStart < 0) {
+		if (lockstep.packetsReceived == 0) {
+			lockstep.send(now, 0, 0);
+			return;
+		}
+		lockstepStart = now;
+	}
+
+	if (lockstep.rollbackTick != 0) {
+		uint32_t current = GameClock::tick();
+		restoreRollbackFrame(lockstep.rollbackTick - 1);
+		lockstep.rollbackTick = 0;
+		lockstep.rollbacks++;
+		GameSound::setMuted(true);
+		while (GameClock::tick() < current) {
+			saveRollbackFrame(GameClock::tick());
+			stepGame();
+		}
+		GameSound::setMuted(false);
+	}
+
+	uint32_t due = (now - lockstepStart) / GameClock::stepMillis();
+	for (int n = 0; n < LOCKSTEP_CATCHUP && GameClock::tick() < due; n++) {
+		uint32_t tick = GameClock::tick() + 1;
+		if (!lockstep.canAdvance(tick)) break;
+		saveRollbackFrame(tick - 1);
+		lockstep.setLocalInput(tick, localInput | startInput);
+		startInput = 0;
+		stepGame();
+	}
+
+	//tell the peer our checksum for the newest tick both inputs are known for
+	lockstep.verify(GameClock::tick(), checksum);
+	uint32_t checked = MIN(lockstep.confirmedTick(), GameClock::tick());
+	uint64_t sum = 0;
+	if (!checksum.lookup(checked, sum)) checked = 0;
+	lockstep.send(now, checked, sum);
+}
+
+//  Rollback state for the end of tick; the snapshot also records the tick
+//
+void ofApp::saveRollbackFrame(uint32_t tick) {
+	rollbackFrames[tick % LOCKSTEP_WINDOW].save(*this);
+	rollbackSchedulers[tick % LOCKSTEP_WINDOW] = scheduler;
+}
+
+void ofApp::restoreRollbackFrame(uint32_t tick) {
+	rollbackFrames[tick % LOCKSTEP_WINDOW].restore(*this);
+	scheduler = rollbackSchedulers[tick % LOCKSTEP_WINDOW];
+}
+
+//  With lockstep the key handlers only record input bits; each tick the
+//  turret is driven by player 0's input and the right enemy by player 1's.
+//
+void ofApp::applyInputs(uint8_t turretInput, uint8_t enemyInput) {
+	if (game_state == "start" && ((turretInput | enemyInput) & INPUT_START)) {
+		game_state = "game";
+		scheduler.resync(GameClock::millis());
+	}
+
+	up = turretInput & INPUT_UP;
+	down = turretInput & INPUT_DOWN;
+	left = turretInput & INPUT_LEFT;
+	right = turretInput & INPUT_RIGHT;
+	firing = turretInput & INPUT_FIRE;
+	life = firing ? 7 : -1;
+	if (turretInput & INPUT_ROTATE_RIGHT) playerState = "rotateRight";
+	else if (turretInput & INPUT_ROTATE_LEFT) playerState = "rotateLeft";
+	else if (up) playerState = left ? "upLeft" : (right ? "upRight" : "moveUp");
+	else if (down) playerState = left ? "downLeft" : (right ? "downRight" : "moveDown");
+	else if (left) playerState = "moveLeft";
+	else if (right) playerState = "moveRight";
+	else playerState = "idle";
+
+	if (enemyInput & INPUT_UP) enemyT->force = ofVec3f(0, -100, 0);
+	else if (enemyInput & INPUT_DOWN) enemyT->force = ofVec3f(0, 100, 0);
+	else enemyT->force = ofVec3f(0, 0, 0);
+}
+
+//  One tick of gameplay
+//
+void ofApp::stepGame() {
+	if (deterministic) GameClock::step();
+	if (lockstep.isActive()) applyInputs(lockstep.input(0, GameClock::tick()), lockstep.input(1, GameClock::tick()));
+
+	//length of this step; it follows the simulation, which runs at its own
+	//rate on simThread, not the frame rate
+	double now = GameClock::millis();
+	if (GameClock::isFixed()) stepSeconds = GameClock::stepMillis() / 1000;
+	else if (lastStepTime >= 0) stepSeconds = MIN((now - lastStepTime) / 1000, 0.1);
+	else stepSeconds = 1 / 60.0;
+	lastStepTime = now;
+
+	//scale effects to the current quality level before anything spawns
+	explosion.setGroupSize(budget.groupSize(explosionGroupSize));
+	explosion.sys->maxParticles = budget.particleCap();
+	turbForce->enabled = budget.evaluateTurbulence();
+
 	explosion.update();
 	if (game_state == "game") {
 
 		turret->integrate();
 		enemy->integrate();
 		enemyT->integrate();
+		scene.update();
 		
 
 		
@@ -483,15 +809,19 @@ void ofApp::update() {
 		turret->setupSpeed(speed);
 		turret->update();
 
+		//the effect budget follows this machine's frame times, so it may
+		//not thin out spawns in deterministic runs
+		float rateScale = deterministic ? 1 : budget.spawnRateScale();
+
 		//updating the LHS enemy emitter
 		enemy->update();
 		//enemy->setLifespan(leftEnemyLife * 1000);
-		enemy->setRate(leftEnemyRate);
+		enemy->setRate(leftEnemyRate * rateScale);
 
 		//updating the RHS enemy emitter
 		enemyT->update();
 		//enemyT->setLifespan(rightEnemyLife * 1000);
-		enemyT->setRate(rightEnemyRate);
+		enemyT->setRate(rightEnemyRate * rateScale);
 
 
 
@@ -507,7 +837,24 @@ void ofApp::update() {
 
 
 		//check bullet collisions
+		int turretShots = turret->sys->sprites.size();
+		int leftShots = enemy->sys->sprites.size();
+		int rightShots = enemyT->sys->sprites.size();
 		checkCollision();
+		pairCounter->add(turretShots * (leftShots + 1) + turretShots * (rightShots + 1) + leftShots + rightShots + 2);
+		events.dispatch();
+		health.apply();
+		turret->sys->reap();
+		enemy->sys->reap();
+		enemyT->sys->reap();
+
+		if (!health.isAlive(turret->healthSlot)) {
+			explosion.setPosition(ofVec3f(turret->trans));
+			explosion.sys->reset();
+			explosion.start();
+			gameOver = true;
+			game_state = "end";
+		}
 
 
 		//prevent player going outside
@@ -517,95 +864,63 @@ void ofApp::update() {
 		if (turret->trans.x <= 0) {
 			turret->setPosition(ofVec3f(1, turret->trans.y, 0));
 		}
-		if (turret->trans.x >= ofGetWindowWidth()) {
-			turret->setPosition(ofVec3f(ofGetWindowWidth() - 1, turret->trans.y, 0));
+		if (turret->trans.x >= playWidth()) {
+			turret->setPosition(ofVec3f(playWidth() - 1, turret->trans.y, 0));
 		}
-		if (turret->trans.y >= ofGetWindowHeight()) {
-			turret->setPosition(ofVec3f(turret->trans.x, ofGetWindowHeight() - 1, 0));
+		if (turret->trans.y >= playHeight()) {
+			turret->setPosition(ofVec3f(turret->trans.x, playHeight() - 1, 0));
 		}
 
 
-		if (enemyT->trans.y >= ofGetWindowHeight()) {
-			enemyT->setPosition(ofVec3f(enemyT->trans.x, ofGetWindowHeight() - 1, 0));
+		if (enemyT->trans.y >= playHeight()) {
+			enemyT->setPosition(ofVec3f(enemyT->trans.x, playHeight() - 1, 0));
 		}
 		if (enemyT->trans.y <= 0) {
 			enemyT->setPosition(ofVec3f(enemyT->trans.x,  1, 0));
 		}
 
-		float time = ofGetElapsedTimeMillis();
-		//generating enemy sprites from the LHS emitter	
-		if ((time - (*enemy).lastSpawned) > (1000.0 / enemy->rate)) {
-			Sprite sprite;
-			sprite.setImage(targetImage);
-			sprite.velocity = (*enemy).velocity;
-			sprite.lifespan = leftEnemyLife * 1000;
-			sprite.setPosition((*enemy).trans);
-			sprite.birthtime = time;
-			sprite.width = enemy->childWidth;
-			sprite.height = enemy->childHeight;
-			(*enemy).sys->add(sprite);
-			(*enemy).lastSpawned = time;
-			//bullet.play();
-		}
-		//movements of the sprites generated by the LHS emitter
-		for (int i = 0; i < enemy->sys->sprites.size(); i++) {
-			enemy->sys->sprites[i].trans += (enemy->sys->sprites[i].velocity.getNormalized() * leftEnemyFiringSpeed / ofGetFrameRate());
-		}
-
-		//generating enemy sprites from the RHS emitter	
-		if ((time - (*enemyT).lastSpawned) > (1000.0 / enemyT->rate)) {
-			Sprite sprite;
-			sprite.setImage(targetImage);
-			sprite.velocity = (*enemyT).velocity;
-			sprite.lifespan = rightEnemyLife * 1000;
-			sprite.setPosition((*enemyT).trans);
-			sprite.birthtime = time;
-			sprite.width = enemyT->childWidth;
-			sprite.height = enemyT->childHeight;
-			(*enemyT).sys->add(sprite);
-			(*enemyT).lastSpawned = time;
-			//bullet.play();
-		}
-
-		//movements of the sprites generated by the RHS emitter
-		for (int i = 0; i < enemyT->sys->sprites.size(); i++) {
-			enemyT->sys->sprites[i].trans += (enemyT->sys->sprites[i].velocity.getNormalized() * rightEnemyFiringSpeed / ofGetFrameRate());
-		}
-
-
+		//generating sprites from all emitters; everything due this frame
+		//is spawned in one batch, already moved to where it should be now
+		double time = GameClock::millis();
+		scheduler.setRate(leftWave, enemy->rate, time);
+		scheduler.setRate(rightWave, enemyT->rate, time);
+		scheduler.setRate(turretWave, turret->rate, time);
 		//shoot
-		if (life > 0) {
-			if ((time - (*turret).lastSpawned) > (1000.0 / turret->rate)) {
-				Sprite sprite;
-				sprite.setImage(bulletImage);
-				sprite.velocity = (*turret).head * 100;
-				sprite.lifespan = 2000;
-				sprite.setPosition((*turret).trans);
-				sprite.birthtime = time;
-				sprite.width = turret->childWidth;
-				sprite.height = turret->childHeight;
-				(*turret).sys->add(sprite);
-				(*turret).lastSpawned = time;
-				bullet.play();
-			}
-		}
-
-		for (int i = 0; i < turret->sys->sprites.size(); i++) {
-			turret->sys->sprites[i].trans += turret->sys->sprites[i].velocity.getNormalized() * 400 / ofGetFrameRate();
-		}
+		scheduler.setEnabled(turretWave, life > 0, time);
+		scheduler.waves[leftWave].speed = leftEnemyFiringSpeed + spriteDrift;
+		scheduler.waves[leftWave].lifespan = leftEnemyLife * 1000;
+		scheduler.waves[rightWave].speed = rightEnemyFiringSpeed + spriteDrift;
+		scheduler.waves[rightWave].lifespan = rightEnemyLife * 1000;
 
 		//EXTRA CREDIT PART I: interesting moving paths
-
-		if (parabola) {
-			enemy->move();
-			enemyT->move();
+		//new enemy shots follow the selected path from the moment they are fired;
+		//homing steers with libm trig, so deterministic runs fire straight
+		TrajectoryPattern enemyPath = (homing && !deterministic) ? TrajHoming : (parabola ? TrajParabola : (sine ? TrajSine : TrajLinear));
+		scheduler.waves[leftWave].pattern = enemyPath;
+		scheduler.waves[rightWave].pattern = enemyPath;
+
+		//the emitters may have been kept on screen above
+		scene.update();
+		scheduler.tick(time);
+		events.dispatch();
+
+		//movements of all the sprites, evaluated from their paths
+		turret->sys->evaluateTrajectories(time);
+		enemy->sys->evaluateTrajectories(time);
+		enemyT->sys->evaluateTrajectories(time);
+
+		//homing shots chase the player
+		homingTargets.clear();
+		homingTargets.push_back(turret->trans);
+		homingSteering.setTargets(homingTargets);
+		homingSteering.steer(*enemy->sys, stepSeconds, tickArena);
+		homingSteering.steer(*enemyT->sys, stepSeconds, tickArena);
+
+		if (circle && deterministic) {
+			fixed16 t = toFixed(GameClock::seconds());
+			enemy->force = ofVec3f(toFloat(fixedCos(t)) * 50, toFloat(fixedSin(t)) * 50, 0);
 		}
-		if (sine) {
-			enemy->sine();
-			enemyT->sine();
-		}
-
-		if (circle) {
+		else if (circle) {
 			enemy->force = ofVec3f(cos(ofGetElapsedTimef()) * 50, sin(ofGetElapsedTimef()) * 50, 0);
 			
 		}
@@ -625,264 +940,321 @@ void ofApp::update() {
 			enemy->drawable = false;
 			enemyT->stop();
 			enemyT->drawable = false;
-			turret->sys->sprites.clear();
-			enemy->sys->sprites.clear();
-			enemyT->sys->sprites.clear();
+			turret->sys->clear();
+			enemy->sys->clear();
+			enemyT->sys->clear();
 		}
 
-		if (enemy->lifespan <= 0) {
+		if (!health.isAlive(enemy->healthSlot)) {
 			enemy->trans = ofVec3f(-1000, -1000, 0);
 			enemy->stop();
 			enemy->drawable = false;
-			enemy->sys->sprites.clear();
+			enemy->sys->clear();
 		}
 
-		if (enemyT->lifespan <= 0) {
+		if (!health.isAlive(enemyT->healthSlot)) {
 			enemyT->trans = ofVec3f(-1000, -1000, 0);
 			enemyT->stop();
 			enemyT->drawable = false;
-			enemyT->sys->sprites.clear();
+			enemyT->sys->clear();
 		}
 
 
-		if (enemyT->lifespan <= 0 && enemy->lifespan <= 0) {
+		if (!health.isAlive(enemyT->healthSlot) && !health.isAlive(enemy->healthSlot)) {
 			w.play();
 			turret->stop();
 			turret->drawable = false;
-			turret->sys->sprites.clear();
+			turret->sys->clear();
 			game_state = "win";
 		}
 	}
-	
-	
 
+	if (deterministic) checksum.record(GameClock::tick(), checksum.compute(*this));
+
+	//scratch memory lives for one tick
+	tickArena.reset();
+}
+
+
+//  Subscribers for gameplay events, in the order they see each batch:
+//  score and damage, explosions, sound, metrics. Sounds restart when
+//  played, so each is played at most once per batch.
+//
+void ofApp::setupEvents() {
+	events.subscribe([this](const GameEvent *e, int n) {
+		Emitter *emitters[3] = { turret, enemy, enemyT };
+		for (int i = 0; i < n; i++) {
+			switch (e[i].type) {
+			case EventShotHit:
+				score += 1;
+				break;
+			case EventEmitterHit:
+			case EventPlayerHit:
+				health.damage(emitters[e[i].type == EventPlayerHit ? 0 : e[i].target]->healthSlot, e[i].amount);
+				break;
+			case EventPlayerCrash:
+				health.damage(turret->healthSlot, e[i].amount);
+				turret->trans = ofVec3f(playWidth() / 2.0, playHeight() / 2.0, 0);
+				break;
+			default:
+				break;
+			}
+		}
+	});
+	events.subscribe([this](const GameEvent *e, int n) {
+		for (int i = 0; i < n; i++) {
+			if (e[i].type != EventShotHit && e[i].type != EventEmitterHit && e[i].type != EventPlayerHit) continue;
+			explosion.setPosition(ofVec3f(e[i].pos));
+			explosion.sys->reset();
+			explosion.start();
+		}
+	});
+	events.subscribe([this](const GameEvent *e, int n) {
+		bool fired = false, exploded = false;
+		for (int i = 0; i < n; i++) {
+			if (e[i].type == EventSpawn) fired |= e[i].target == turretWave;
+			else exploded = true;
+		}
+		if (fired) bullet.play();
+		if (exploded) explode.play();
+	});
+	events.subscribe([this](const GameEvent *e, int n) {
+		for (int i = 0; i < n; i++) {
+			switch (e[i].type) {
+			case EventSpawn: spawnCounter->add(); break;
+			case EventShotHit: hitCounter->add(); break;
+			case EventPlayerHit:
+			case EventPlayerCrash: playerHitCounter->add(e[i].amount); break;
+			default: break;
+			}
+		}
+	});
+}
+
+//  Metrics exported with --metrics. Everything is registered up front so
+//  the per frame cost is a handful of relaxed atomic updates.
+//
+void ofApp::setupMetrics() {
+	spriteGauges[0] = metrics.gauge("game_turret_sprites", "Live player shots");
+	spriteGauges[1] = metrics.gauge("game_left_enemy_sprites", "Live shots from the left enemy");
+	spriteGauges[2] = metrics.gauge("game_right_enemy_sprites", "Live shots from the right enemy");
+	particleGauge = metrics.gauge("game_particles", "Live explosion particles");
+	qualityGauge = metrics.gauge("game_effect_level", "Effect budget quality level");
+	spawnCounter = metrics.counter("game_spawns_total", "Sprites spawned by all waves");
+	pairCounter = metrics.counter("game_collision_pairs_total", "Collision pairs tested");
+	hitCounter = metrics.counter("game_hits_total", "Enemy shots destroyed by the player");
+	playerHitCounter = metrics.counter("game_player_damage_total", "Life lost by the player");
+	events.overflows = metrics.counter("game_event_overflows_total", "Times the event bus ring was full and grown");
+	frameHistogram = metrics.histogram("game_frame_time_us", "Time between frames in microseconds");
+	updateHistogram = metrics.histogram("game_update_time_us", "update() time in microseconds");
+	drawHistogram = metrics.histogram("game_draw_time_us", "draw() time in microseconds");
+	for (int t = 0; t < MEMORY_TAGS; t++)
+		memoryGauges[t] = metrics.gauge(string("game_heap_") + MemoryTracker::name(t) + "_bytes", string("Heap bytes in use for ") + MemoryTracker::name(t));
+	allocHistogram = metrics.histogram("game_frame_allocations", "Heap allocations per frame, ui and audio excluded");
+	if (!metricsPath.empty()) metrics.setOutput(metricsPath, 1000);
 }
 
+void ofApp::recordMetrics() {
+	spriteGauges[0]->set(turret->sys->sprites.size());
+	spriteGauges[1]->set(enemy->sys->sprites.size());
+	spriteGauges[2]->set(enemyT->sys->sprites.size());
+	particleGauge->set(explosion.sys->particles.size());
+	qualityGauge->set(budget.level);
+	frameHistogram->record(budget.loopMs * 1000);
+	updateHistogram->record(budget.updateMs * 1000);
+	drawHistogram->record(budget.drawMs * 1000);
+	for (int t = 0; t < MEMORY_TAGS; t++)
+		memoryGauges[t]->set(MemoryTracker::current(t));
+	metrics.update(ofGetElapsedTimeMillis());
+}
+
+//  Close the allocation frame. Once gameplay has run for
+//  ALLOC_WARMUP_FRAMES, a frame allocating more than allocLimit times
+//  counts as a failure. UI text and audio are left out; they allocate
+//  whenever what they show or play changes.
+//
+void ofApp::checkAllocations() {
+	MemoryTracker::frame();
+	uint64_t n = 0;
+	for (int t = 0; t < MEMORY_TAGS; t++)
+		if (t != MemUI && t != MemAudio) n += MemoryTracker::frameAllocations(t);
+	allocHistogram->record(n);
+
+	if (renderBuffer.latest().gameState == GameSnapshot::stateToInt("game")) steadyFrames++;
+	else steadyFrames = 0;
+	if (allocLimit < 0 || steadyFrames <= ALLOC_WARMUP_FRAMES || n <= (uint64_t)allocLimit) return;
+	if (allocFailures == 0) {
+		MemoryScope scope(MemUI);
+		cout << "memory: " << n << " allocations in one gameplay frame, limit " << allocLimit << " (" << MemoryTracker::frameSummary() << ")" << endl;
+	}
+	allocFailures++;
+}
 
 //--------------------------------------------------------------
 void ofApp::draw() {
+	if (buildPack) return;
 	
-	if (game_state == "start") {
+	budget.beginDraw();
+	RenderBackend *render = RenderBackend::get();
+	render->begin();
+
+	//everything below comes from the newest simulation step
+	const RenderSnapshot &frame = renderBuffer.latest();
+	string state = GameSnapshot::intToState(frame.gameState);
+
+	if (state == "start") {
 		
-		start_screen.draw(0, 0, ofGetWindowWidth(), ofGetWindowHeight());
+		compositor.drawStatic(startLayer);
 		
 	}
-	if (game_state == "game") {
-		background.draw(0, 0, ofGetWindowWidth(), ofGetWindowHeight());
-		if (turret->lifespan > 0) {
-			turret->draw();
+	if (state == "game") {
+		compositor.drawStatic(backgroundLayer);
+		render->setColor(ofColor(255, 255, 255));
+		for (int i = 0; i < frame.images.size(); i++) {
+			const ImageDraw &d = frame.images[i];
+			render->drawImage(*d.image, d.matrix, d.x, d.y);
 		}
-		
-		enemy->draw();
-		enemyT->draw();
-		turret->sys->draw();
-		enemy->sys->draw();
-		enemyT->sys->draw();
-		if (!bHide) {
+		if (!bHide && !render->isSoftware()) {
+			MemoryScope uiScope(MemUI);
 			gui.draw();
 		}
 		
-		//display socre, life
-		string lifeText;
-		string scoreText;
-		int l = turret->lifespan;
-		lifeText += "Life: " + std::to_string(l);
-		scoreText += "Score: " + std::to_string(score);
+		//display socre, life; the text meshes only change with the values
+		scoreHud.setValue(frame.score);
+		lifeHud.setValue(frame.life);
 		//ofDrawBitmapString(scoreText, ofPoint(ofGetWindowWidth()/2, ofGetWindowHeight()-20));
-		font.drawString(scoreText, ofGetWindowWidth() / 2 - font.stringWidth(scoreText) *2  , ofGetWindowHeight() - 20);
+		scoreHud.draw(ofGetWindowWidth() / 2 - scoreHud.getWidth() * 2, ofGetWindowHeight() - 20);
 
-		font.drawString(lifeText, ofGetWindowWidth() / 2 + font.stringWidth(lifeText) , ofGetWindowHeight() - 20);
+		lifeHud.draw(ofGetWindowWidth() / 2 + lifeHud.getWidth(), ofGetWindowHeight() - 20);
 		
 	}
-	if (game_state == "end") {
+	if (state == "end") {
 		
 		bgm.stop();
 		
-		string text = "GAME OVER";
-		string scoreText;
-		scoreText += "Score: " + std::to_string(score);
-		end_screen.draw(0, 0, ofGetWindowWidth(), ofGetWindowHeight());
-		font.drawString(text, ofGetWindowWidth() / 2 - font.stringWidth(text) / 2, ofGetWindowHeight() / 2 - font.stringHeight(text) / 2);
-		font.drawString(scoreText, ofGetWindowWidth() / 2 - font.stringWidth(scoreText) / 2, ofGetWindowHeight() / 2 + 20);
+		scoreHud.setValue(frame.score);
+		compositor.drawStatic(endLayer);
+		gameOverHud.draw(ofGetWindowWidth() / 2 - gameOverHud.getWidth() / 2, ofGetWindowHeight() / 2 - gameOverHud.getHeight() / 2);
+		scoreHud.draw(ofGetWindowWidth() / 2 - scoreHud.getWidth() / 2, ofGetWindowHeight() / 2 + 20);
 	}
 
-	if (game_state == "win") {
+	if (state == "win") {
 		bgm.stop();
-		string text = "CONGRATS! YOU WIN";
-		string scoreText;
-		scoreText += "Score: " + std::to_string(score);
-		end_screen.draw(0, 0, ofGetWindowWidth(), ofGetWindowHeight());
-		font.drawString(text, ofGetWindowWidth() / 2 - font.stringWidth(text) / 2, ofGetWindowHeight() / 2 - font.stringHeight(text) / 2);
-		font.drawString(scoreText, ofGetWindowWidth() / 2 - font.stringWidth(scoreText) / 2, ofGetWindowHeight() / 2 + 20);
+		scoreHud.setValue(frame.score);
+		compositor.drawStatic(endLayer);
+		winHud.draw(ofGetWindowWidth() / 2 - winHud.getWidth() / 2, ofGetWindowHeight() / 2 - winHud.getHeight() / 2);
+		scoreHud.draw(ofGetWindowWidth() / 2 - scoreHud.getWidth() / 2, ofGetWindowHeight() / 2 + 20);
 	}
 
 
-	explosion.draw();
+	//explosion
+	render->drawCircles(frame.circles.data(), frame.circles.size());
 
-	if (!bHide) { gui.draw(); }
+	if (!bHide && !render->isSoftware()) {
+		MemoryScope uiScope(MemUI);
+		gui.draw();
+	}
 
-	ofSetColor(255, 255, 255);
-	
+	render->setColor(ofColor(255, 255, 255));
+	render->end();
+	budget.endDraw();
 	
 }
-//Check collisions
+//  Positions of every sprite in sys as x and y arrays in tick scratch
+//  memory, for the batch distance tests
+//
+struct SpritePoints {
+	float *x, *y;
+	int n;
+};
+
+static SpritePoints gatherPositions(const SpriteSystem &sys, FrameArena &arena) {
+	const vector<Sprite> &sprites = sys.sprites;
+	SpritePoints p;
+	p.n = sprites.size();
+	p.x = arena.allocArray<float>(p.n);
+	p.y = arena.allocArray<float>(p.n);
+	for (int i = 0; i < p.n; i++) {
+		p.x[i] = sprites[i].trans.x;
+		p.y[i] = sprites[i].trans.y;
+	}
+	return p;
+}
+
+//Check collisions; hits are only published here, see setupEvents() for
+//what they do
 void ofApp::checkCollision() {
-		float collisionDistL = turret->childHeight / 2 + enemy->height / 2; //Collision distance with the left enemy emitter
-		float collisionDistR = turret->childHeight / 2 + enemyT->height / 2;//Collision distance with the right enemy emitter
-		float collisionDistC = turret->childHeight / 2 + enemy->childHeight / 2;// Collsion distance with the enemy sprites
-		float collisionDistP = turret->height / 2 + enemy->childHeight / 2;
-		float collisionDistP2 = turret->height / 2 + enemyT->childHeight / 2;
-		float c1 = turret->height / 2 + enemy->height / 2;
-		float c2 = turret->height / 2 + enemyT->height / 2;
+		//every pair is first found by a batched bounding circle query (or a
+		//single bounding circle test) and then checked against the exact
+		//hitboxes; see CollisionShape
+		SpritePoints shots = gatherPositions(*turret->sys, tickArena);
+		SpritePoints leftShots = gatherPositions(*enemy->sys, tickArena);
+		SpritePoints rightShots = gatherPositions(*enemyT->sys, tickArena);
+		int *hits = tickArena.allocArray<int>(MAX(leftShots.n, rightShots.n));
+		ShapePose player = pose(turretNode);
+		ShapePose left = pose(leftNode), right = pose(rightNode);
+		const CollisionShape &shotShape = turret->childShape;
 		
 		//collisions with the left enemy emitter
-		for (int i = 0; i < turret->sys->sprites.size(); i++) {
-			//convert glm::vec3 to ofVec3f to use distance() method
-			ofVec3f player = ofVec3f(turret->sys->sprites[i].trans.x, turret->sys->sprites[i].trans.y, turret->sys->sprites[i].trans.z);
-			
-			ofVec3f emitter = ofVec3f(enemy->trans.x, enemy->trans.y, enemy->trans.z);
-			//calculating distances
-			
-			float distanceE = player.distance(emitter);
-			for (int j = 0; j< enemy->sys->sprites.size() ; j++) {
-				ofVec3f invader = ofVec3f(enemy->sys->sprites[j].trans.x, enemy->sys->sprites[j].trans.y, enemy->sys->sprites[j].trans.z);
-				float distance = player.distance(invader);
-				//if distance<=collion distance, enemy sprite/bullet sprite disappears, update score and play sound
-				if (distance <= collisionDistC) {
-					enemy->sys->sprites[j].lifespan = 0;
-					turret->sys->sprites[i].lifespan = 0;
-					score += 1;
-					explosion.setPosition(ofVec3f(turret->sys->sprites[i].trans));
-					explosion.sys->reset();
-					explosion.start();
-					explode.play();
-				}
-				
-
-				}
-			if (distanceE <= collisionDistL) {
-				turret->sys->sprites[i].lifespan = 0;
-				enemy->lifespan -= 100;
-
-				explosion.setPosition(ofVec3f(turret->sys->sprites[i].trans));
-				explosion.sys->reset();
-				explosion.start();
-
-				explode.play();
+		for (int i = 0; i < shots.n; i++) {
+			ShapePose shot(float2(shots.x[i], shots.y[i]));
+			//if the hitboxes touch, enemy sprite/bullet sprite disappears, update score and play sound
+			int n = withinRadius(leftShots.x, leftShots.y, leftShots.n, shot.pos, shotShape.radius + enemy->childShape.radius, hits);
+			for (int k = 0; k < n; k++) {
+				ShapePose target(float2(leftShots.x[hits[k]], leftShots.y[hits[k]]));
+				if (!shapesOverlap(shotShape, shot, enemy->childShape, target)) continue;
+				enemy->sys->kill(hits[k]);
+				turret->sys->kill(i);
+				events.publish(EventShotHit, 1, 0, turret->sys->sprites[i].trans);
 			}
-
+			if (shapesOverlap(shotShape, shot, enemy->shape, left)) {
+				turret->sys->kill(i);
+				events.publish(EventEmitterHit, 1, 100, turret->sys->sprites[i].trans);
 			}
-		//collisions with the right enemy emitter
-		for (int i = 0; i < turret->sys->sprites.size(); i++) {
-			ofVec3f player = ofVec3f(turret->sys->sprites[i].trans.x, turret->sys->sprites[i].trans.y, turret->sys->sprites[i].trans.z);
-			ofVec3f emitter = ofVec3f(enemyT->trans.x, enemyT->trans.y, enemyT->trans.z);
-			float distanceE = player.distance(emitter);
-			for (int j = 0; j < enemyT->sys->sprites.size(); j++) {
-				//convert glm::vec3 to ofVec3f to use distance() method
-			//	ofVec3f player = ofVec3f(turret->sys->sprites[i].trans.x, turret->sys->sprites[i].trans.y, turret->sys->sprites[i].trans.z);
-				ofVec3f invader = ofVec3f(enemyT->sys->sprites[j].trans.x, enemyT->sys->sprites[j].trans.y, enemyT->sys->sprites[j].trans.z);
-				//ofVec3f emitter = ofVec3f(enemyT->trans.x, enemyT->trans.y, enemyT->trans.z);
-				float distance = player.distance(invader);
-				float distanceE = player.distance(emitter);
-				//if distance<=collion distance, enemy sprite/bullet sprite disappears, play sound
-				if (distance <= collisionDistC) {
-					enemyT->sys->sprites[j].lifespan = 0;
-					turret->sys->sprites[i].lifespan = 0;
-					score += 1;
-					explosion.setPosition(ofVec3f(turret->sys->sprites[i].trans));
-					explosion.sys->reset();
-					explosion.start();
-
-					explode.play();
-				}
-				
-
-			}
-
-			if (distanceE <= collisionDistL) {
-				turret->sys->sprites[i].lifespan = 0;
-				enemyT->lifespan -= 100;
-				explosion.setPosition(ofVec3f(turret->sys->sprites[i].trans));
-				explosion.sys->reset();
-				explosion.start();
-
-				explode.play();
-			}
-
 		}
 
-
-		for (int i = 0; i < enemy->sys->sprites.size(); i++) {
-			//for (int j = 0; j < enemyT->sys->sprites.size(); j++) {
-				ofVec3f player = ofVec3f(turret->trans.x, turret->trans.y, turret->trans.z);
-				ofVec3f invader = ofVec3f(enemy->sys->sprites[i].trans.x, enemy->sys->sprites[i].trans.y, enemy->sys->sprites[i].trans.z);
-				//ofVec3f invader2 = ofVec3f(enemyT->sys->sprites[j].trans.x, enemyT->sys->sprites[j].trans.y, enemyT->sys->sprites[j].trans.z);
-				ofVec3f emitter = ofVec3f(enemy->trans.x, enemy->trans.y, enemy->trans.z);
-				ofVec3f emitter2 = ofVec3f(enemyT->trans.x, enemyT->trans.y, enemyT->trans.z);
-				float distance = player.distance(invader);
-				if (distance <= collisionDistP) {
-					enemy->sys->sprites[i].lifespan = 0;
-					turret->lifespan =  turret->lifespan - 1;
-					cout << turret->lifespan << endl;;
-					//gameOver = true;
-					explosion.setPosition(ofVec3f(turret->trans));
-					explosion.sys->reset();
-					explosion.start();
-
-					explode.play();
-				//}
+		//collisions with the right enemy emitter
+		for (int i = 0; i < shots.n; i++) {
+			ShapePose shot(float2(shots.x[i], shots.y[i]));
+			//if the hitboxes touch, enemy sprite/bullet sprite disappears, play sound
+			int n = withinRadius(rightShots.x, rightShots.y, rightShots.n, shot.pos, shotShape.radius + enemyT->childShape.radius, hits);
+			for (int k = 0; k < n; k++) {
+				ShapePose target(float2(rightShots.x[hits[k]], rightShots.y[hits[k]]));
+				if (!shapesOverlap(shotShape, shot, enemyT->childShape, target)) continue;
+				enemyT->sys->kill(hits[k]);
+				turret->sys->kill(i);
+				events.publish(EventShotHit, 2, 0, turret->sys->sprites[i].trans);
 			}
-		}
-
-		for (int i = 0; i < enemyT->sys->sprites.size(); i++) {
-			//for (int j = 0; j < enemyT->sys->sprites.size(); j++) {
-			ofVec3f player = ofVec3f(turret->trans.x, turret->trans.y, turret->trans.z);
-			ofVec3f invader = ofVec3f(enemyT->sys->sprites[i].trans.x, enemyT->sys->sprites[i].trans.y, enemyT->sys->sprites[i].trans.z);
-			//ofVec3f invader2 = ofVec3f(enemyT->sys->sprites[j].trans.x, enemyT->sys->sprites[j].trans.y, enemyT->sys->sprites[j].trans.z);
-			ofVec3f emitter = ofVec3f(enemy->trans.x, enemy->trans.y, enemy->trans.z);
-			ofVec3f emitter2 = ofVec3f(enemyT->trans.x, enemyT->trans.y, enemyT->trans.z);
-			float distance = player.distance(invader);
-			if (distance <= collisionDistP2) {
-				enemyT->sys->sprites[i].lifespan = 0;
-				turret->lifespan = turret->lifespan - 1;
-				cout << turret->lifespan << endl;;
-				//gameOver = true;
-				explosion.setPosition(ofVec3f(turret->trans));
-				explosion.sys->reset();
-				explosion.start();
-
-				explode.play();
-				//}
+			if (shapesOverlap(shotShape, shot, enemyT->shape, right)) {
+				turret->sys->kill(i);
+				events.publish(EventEmitterHit, 2, 100, turret->sys->sprites[i].trans);
 			}
 		}
 
-		ofVec3f t = ofVec3f(turret->trans.x, turret->trans.y, turret->trans.z);
-		ofVec3f el = ofVec3f(enemy->trans.x, enemy->trans.y, enemy->trans.z);
-		ofVec3f er = ofVec3f(enemyT->trans.x, enemyT->trans.y, enemyT->trans.z);
-		float d1 = t.distance(el);
-		float d2 = t.distance(er);
-		if (d1 <= c1 || d2 <= c2) {
-			turret->lifespan = turret->lifespan - 5;
-			turret->trans = ofVec3f(ofGetWindowWidth() / 2.0, ofGetWindowHeight() / 2.0, 0);
-			explode.play();
+		//enemy shots hitting the player
+		int n = withinRadius(leftShots.x, leftShots.y, leftShots.n, player.pos, turret->shape.radius + enemy->childShape.radius, hits);
+		for (int k = 0; k < n; k++) {
+			ShapePose target(float2(leftShots.x[hits[k]], leftShots.y[hits[k]]));
+			if (!shapesOverlap(turret->shape, player, enemy->childShape, target)) continue;
+			enemy->sys->kill(hits[k]);
+			events.publish(EventPlayerHit, 1, 1, turret->trans);
 		}
-		
-
-		if (turret->lifespan <= 0) {
-			explosion.setPosition(ofVec3f(turret->trans));
-			explosion.sys->reset();
-			explosion.start();
-			gameOver = true;
-			game_state = "end";
+		n = withinRadius(rightShots.x, rightShots.y, rightShots.n, player.pos, turret->shape.radius + enemyT->childShape.radius, hits);
+		for (int k = 0; k < n; k++) {
+			ShapePose target(float2(rightShots.x[hits[k]], rightShots.y[hits[k]]));
+			if (!shapesOverlap(turret->shape, player, enemyT->childShape, target)) continue;
+			enemyT->sys->kill(hits[k]);
+			events.publish(EventPlayerHit, 2, 1, turret->trans);
 		}
 
-
-		
+		bool crashLeft = shapesOverlap(turret->shape, player, enemy->shape, left);
+		bool crashRight = shapesOverlap(turret->shape, player, enemyT->shape, right);
+		if (crashLeft || crashRight) {
+			events.publish(EventPlayerCrash, crashLeft ? 1 : 2, 5, turret->trans);
+		}
 }
 
 
-//--------------------------------------------------------------
-
 //--------------------------------------------------------------
 void ofApp::mouseMoved(int x, int y) {
 	//	cout << "mouse( " << x << "," << y << ")" << endl;
@@ -890,7 +1262,8 @@ void ofApp::mouseMoved(int x, int y) {
 
 //--------------------------------------------------------------
 void ofApp::mouseDragged(int x, int y, int button) {
-	
+	std::lock_guard<std::mutex> lock(simMutex);
+	if (!netPeer.empty()) return;    // not an input the peer sees
 	if (x == 0 || y == 0 || x == ofGetWindowWidth() || x == ofGetWindowHeight())
 	{
 		(*turret).trans = (*turret).trans;
@@ -920,16 +1293,9 @@ void ofApp::mouseExited(int x, int y) {
 }
 
 void ofApp::animateTurret() {
-	glm::mat4 rot = glm::rotate(glm::mat4(1.0), glm::radians((*turret).rotation), glm::vec3(0, 0, 1));
-	glm::vec4 temp = glm::vec4(0, 1, 1, 1);
-	glm::vec4 temp1 = glm::vec4(1, 0, 1, 1);
-
-
-	temp = rot * temp;
-	temp1 = rot * temp1;
-	(*turret).head = glm::vec3(-temp.x, -temp.y, 0);
-	(*turret).left = glm::vec3(temp1.x, temp1.y, 0);
-	
+	scene.update();
+	turret->head = ofVec3f(scene.forward(turretNode).vec3());
+	turret->left = ofVec3f(scene.right(turretNode).vec3());
 
 
 	if (playerState == "moveUp") {
@@ -974,7 +1340,27 @@ void ofApp::animateTurret() {
 
 
 
+//  INPUT_* bit for a key; w and s also steer, as they do for the right enemy
+//
+static uint8_t keyInput(int key) {
+	switch (key) {
+	case OF_KEY_UP: case 'w': return INPUT_UP;
+	case OF_KEY_DOWN: case 's': return INPUT_DOWN;
+	case OF_KEY_LEFT: return INPUT_LEFT;
+	case OF_KEY_RIGHT: return INPUT_RIGHT;
+	case ' ': return INPUT_FIRE;
+	case ',': return INPUT_ROTATE_LEFT;
+	case '.': return INPUT_ROTATE_RIGHT;
+	default: return 0;
+	}
+}
+
 void ofApp::keyPressed(int key) {
+	std::lock_guard<std::mutex> lock(simMutex);
+	if (lockstep.isActive()) {
+		localInput |= keyInput(key);
+		return;
+	}
 	if (key == prevKey) {
 		return;
 	}
@@ -1155,10 +1541,20 @@ void ofApp::keyPressed(int key) {
 		playerState = "rotateLeft";
 	}
 
-	if (key == 'h') {
+	//the panel's settings are not sent to the peer, so it stays closed in
+	//a lockstep game
+	if (key == 'h' && netPeer.empty()) {
 		bHide = !bHide;
 	}
 
+	//quick save / quick load of the full game state
+	if (key == 'k') {
+		saveSnapshot();
+	}
+	if (key == 'l') {
+		restoreSnapshot();
+	}
+
 	if (key == 'w') {
 		enemyT->force = ofVec3f(0, -100, 0);
 	}
@@ -1172,12 +1568,19 @@ void ofApp::keyPressed(int key) {
 
 //--------------------------------------------------------------
 void ofApp::keyReleased(int key) {
+	std::lock_guard<std::mutex> lock(simMutex);
+	if (lockstep.isActive()) {
+		localInput &= ~keyInput(key);
+		if (key == ' ' && game_state == "start") startInput = INPUT_START;
+		return;
+	}
 
 
 	prevKey = -9999999999;
 	//start page
 	if (game_state == "start" && key == ' ') {
 		game_state = "game";
+		scheduler.resync(GameClock::millis());
 	}
 	
 
@@ -1221,8 +1624,48 @@ void ofApp::keyReleased(int key) {
 
 }
 
+//--------------------------------------------------------------
+// Snapshot the game into memory and also write it to disk so a heavy
+// mid-game state can be reloaded later (crash repro, benchmarks).
+//
+void ofApp::saveSnapshot() {
+	uint64_t start = ofGetElapsedTimeMicros();
+	snapshot.save(*this);
+	uint64_t elapsed = ofGetElapsedTimeMicros() - start;
+	cout << "snapshot saved: " << snapshot.size() << " bytes in " << elapsed << " us" << endl;
+	snapshot.saveToFile("snapshot.bin");
+}
+
+// Restore the last in-memory snapshot, falling back to the one on disk.
+//
+void ofApp::restoreSnapshot() {
+	if (snapshot.isEmpty() && !snapshot.loadFromFile("snapshot.bin")) {
+		cout << "no snapshot to restore" << endl;
+		return;
+	}
+	uint64_t start = ofGetElapsedTimeMicros();
+	if (snapshot.restore(*this)) {
+		scheduler.resync(GameClock::millis());
+		uint64_t elapsed = ofGetElapsedTimeMicros() - start;
+		cout << "snapshot restored in " << elapsed << " us" << endl;
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::exit() {
+	if (threadedSim) simThread.waitForThread(true);
+	if (bot.active) bot.report(*this);
+	if (allocLimit >= 0) cout << "memory: " << allocFailures << " gameplay frames over " << allocLimit << " allocations" << endl;
+	if (lockstep.isActive()) {
+		cout << "lockstep: tick " << GameClock::tick() << ", sent " << lockstep.packetsSent << " packets / " << lockstep.bytesSent << " bytes, dropped "
+			<< lockstep.packetsDropped << ", received " << lockstep.packetsReceived << ", rollbacks " << lockstep.rollbacks << ", desyncs " << lockstep.desyncs << endl;
+	}
+}
+
 //--------------------------------------------------------------
 void ofApp::windowResized(int w, int h) {
+	if (softwareRender) softRenderer.allocate(w, h);
+	compositor.resize(w, h);
 
 }
 
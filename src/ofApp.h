@@ -5,6 +5,35 @@
 #include "Particle.h"
 #include "ParticleEmitter.h"
 #include "TransformObject.h"
+#include "GameSnapshot.h"
+#include "Trajectory.h"
+#include "SoftwareRenderer.h"
+#include "EffectBudget.h"
+#include "SpawnScheduler.h"
+#include "HomingSteering.h"
+#include "HudText.h"
+#include "LayerCompositor.h"
+#include "AssetPack.h"
+#include "GameSound.h"
+#include "Metrics.h"
+#include "EventBus.h"
+#include "RenderSnapshot.h"
+#include "SimulationThread.h"
+#include "FixedPoint.h"
+#include "GameClock.h"
+#include "StateChecksum.h"
+#include "LockstepSession.h"
+#include "BotDriver.h"
+#include "MemoryTracker.h"
+#include "FrameArena.h"
+#include "VecMath.h"
+#include "SceneGraph.h"
+#include "CollisionShape.h"
+#include "Lifetime.h"
+
+#define ALLOC_WARMUP_FRAMES 300   // gameplay frames before allocLimit applies
+#define PLAYFIELD_WIDTH  1334     // window size, and the playfield in deterministic mode
+#define PLAYFIELD_HEIGHT 750
 
 typedef enum { MoveStop, MoveLeft, MoveRight, MoveUp, MoveDown } MoveDir;
 
@@ -19,14 +48,11 @@ public:
 	bool	bSelected;
 	ofVec3f head;
 	ofVec3f left;
-	glm::mat4 getMatrix() {
-		glm::mat4 tran = glm::translate(glm::mat4(1.0), trans);
-		glm::mat4 rot = glm::rotate(glm::mat4(1.0), glm::radians(rotation), glm::vec3(0, 0, 1));
-		glm::mat4 scale = glm::scale(glm::mat4(1.0), this->scale);
-
-		glm::mat4 T = tran * rot * scale;
-		return T;
-	}
+	const glm::mat4 &getMatrix() const { return transform.get(trans, rotation, scale); }
+	//getMatrix() updates the cache, so only the simulation may call it:
+	//snapshot capture does, and so do Sprite::draw() and Emitter::draw(),
+	//which ofApp::draw() no longer uses since it draws snapshots
+	mutable TransformCache transform;
 	void setPosition(ofVec3f);
 
 	
@@ -47,12 +73,13 @@ public:
 	ofVec3f velocity; // in pixels/sec
 	ofImage image;
 	float birthtime; // elapsed time in ms
-	float lifespan;  //  time in ms
+	float lifespan;  //  time to live in ms, -1 => forever
 	string name;
 	//void update();
 	//ofPoint pos;
 	bool haveImage;
 	float width, height;
+	Trajectory path;   // closed form motion, TrajNone => moved by velocity
 	
 };
 
@@ -62,9 +89,16 @@ class SpriteSystem {
 public:
 	void add(Sprite);
 	void remove(int);
+	void kill(int i) { alive.kill(i); }
+	int reap() { return alive.reap(sprites); }
+	void clear();
 	void update();
 	void draw();
+	void evaluateTrajectories(float time);
 	vector<Sprite> sprites;
+	AliveSet alive;     // sprites killed since the last reap()
+	TrajectoryBatch batch;
+	vector<int> moving;
 	
 };
 
@@ -102,21 +136,23 @@ public:
 	void setRate(float);
 	void update();
 	void integrate();
+	void integrateFixed();
 	SpriteSystem *sys = NULL;
 	float rate;
 	ofVec3f velocity = ofVec3f(0, 0, 0);
-	float lifespan;
+	float lifespan;      // ms, given to the sprites it spawns
+	int healthSlot = -1; // hit points in ofApp::health
 	bool started;
-	float lastSpawned;
+	double lastSpawned;  // ms
 	ofImage childImage;
 	ofImage image;
 	bool drawable;
 	bool haveChildImage;
 	bool haveImage;
 	float width, height, childWidth,childHeight;
-	void move();
+	CollisionShape shape;        // hitbox of the emitter
+	CollisionShape childShape;   // hitbox of each of its sprites
 	int speed;
-	void sine();
 
 	ofVec3f acceleration = ofVec3f(0, 0, 0);
 	ofVec3f force = ofVec3f(0, 0, 0);
@@ -126,6 +162,8 @@ public:
 	float angularForce = 0;
 	float angularVelocity = 0.0;
 	float angularAcceleration = 0.0;
+	FixedBody body = {};
+
 
 
 };
@@ -139,7 +177,10 @@ public:
 
 	void setup();
 	void update();
+	void simulate();
+	void stepGame();
 	void draw();
+	void exit();
 	bool up = false;
 	bool down = false;
 	bool left = false;
@@ -160,11 +201,13 @@ public:
 	//	vector<Emitter *> emitters;
 	//	int numEmitters;
 	void checkCollision();
+	FrameArena tickArena;          // scratch for one stepGame(), reset at its end
 	Emitter  *turret ;
 	Emitter *enemy;
 	Emitter *enemyT;
 
 	ParticleEmitter explosion;
+	ParticleCurve explosionCurve;
 	TurbulenceForce *turbForce;
 	GravityForce *gravityForce;
 	ImpulseRadialForce *radialForce;
@@ -180,13 +223,13 @@ public:
 	ofImage bulletImage;
 	ofImage targetImage;
 	ofImage invaderImage;
-	ofSoundPlayer bullet;
-	ofSoundPlayer explode;
+	GameSound bullet;
+	GameSound explode;
 	ofVec3f mouse_last;
 	bool imageLoaded;
 	int score;
-	ofSoundPlayer bgm;
-	ofSoundPlayer gg;
+	GameSound bgm;
+	GameSound gg;
 	ofxFloatSlider rate;
 	ofxFloatSlider leftEnemyFiringSpeed;
 	ofxFloatSlider rightEnemyFiringSpeed;
@@ -204,15 +247,88 @@ public:
 	ofxToggle parabola;
 	ofxToggle sine;
 	ofxToggle circle;
+	ofxToggle homing;
 	int prevKey = -9999999999;
 	ofxLabel screenSize;
 	void ofApp::animateTurret();
 	string playerState = "idle";
 	ofxPanel gui;
-	ofSoundPlayer w;
+	GameSound w;
 	ofTrueTypeFont font;
 	bool bHide = true;
 	bool gameOver = false;
+	GameSnapshot snapshot;
+	bool softwareRender = false;   // draw on the CPU (no GL context)
+	bool dumpFrames = false;       // with softwareRender, save every frame as png
+	SoftwareRenderer softRenderer;
+	EffectBudget budget;
+	int explosionGroupSize = 20;   // particles per explosion at full quality
+	ofxLabel qualityLabel;
+	SpawnScheduler scheduler;
+	int leftWave, rightWave, turretWave;
+	SceneGraph scene;              // emitters, and the turret's barrels
+	int turretNode, leftNode, rightNode;
+	HealthPool health;             // hit points of the emitters, see Emitter::healthSlot
+	ShapePose pose(int node) const { return ShapePose(scene.position(node), scene.worldCos[node], scene.worldSin[node]); }
+	int barrels = 1;               // turret guns, more than one are fanned out in front
+	HomingSteering homingSteering;
+	HudText scoreHud, lifeHud, gameOverHud, winHud;
+	LayerCompositor compositor;
+	int startLayer, backgroundLayer, endLayer;
+	vector<glm::vec3> homingTargets;
+	int shownLevel = -1, shownThrottles = -1;
+	void saveSnapshot();
+	void restoreSnapshot();
+	bool buildPack = false;        // write data/assets.pack and exit
+	AssetPack assets;
+	bool loadImage(ofImage &img, const string &name);
+	string metricsPath;            // prometheus text file, empty to disable
+	MetricsRegistry metrics;
+	MetricGauge *spriteGauges[3];  // turret, left and right enemy
+	MetricGauge *particleGauge, *qualityGauge;
+	MetricCounter *spawnCounter, *pairCounter, *hitCounter, *playerHitCounter;
+	MetricHistogram *frameHistogram, *updateHistogram, *drawHistogram;
+	void setupMetrics();
+	void recordMetrics();
+	EventBus events;
+	void setupEvents();
+	bool threadedSim = false;      // run simulate() on simThread
+	SimulationThread simThread;
+	std::mutex simMutex;           // held by simulate() and the input handlers
+	RenderSnapshotBuffer renderBuffer;
+	uint64_t simSteps = 0;
+	float stepSeconds = 1 / 60.0;  // length of the current stepGame()
+	double lastStepTime = -1;      // GameClock ms of the last stepGame()
+	bool deterministic = false;    // fixed step clock and fixed point physics
+	//the game is played in the window, except in deterministic mode, where
+	//peers with different window sizes must still agree
+	float playWidth() const { return deterministic ? PLAYFIELD_WIDTH : ofGetWindowWidth(); }
+	float playHeight() const { return deterministic ? PLAYFIELD_HEIGHT : ofGetWindowHeight(); }
+	StateChecksum checksum;
+	LockstepSession lockstep;      // two player mode, active with --peer
+	int netPlayer = 0;
+	int netPort = 7000;
+	string netPeer;
+	uint8_t localInput = 0;        // INPUT_* bits of the keys held here
+	uint8_t startInput = 0;        // INPUT_START for the next tick
+	float lockstepStart = -1;      // ms when the peer was first heard
+	GameSnapshot rollbackFrames[LOCKSTEP_WINDOW];
+	SpawnScheduler rollbackSchedulers[LOCKSTEP_WINDOW];
+	void stepLockstep();
+	void applyInputs(uint8_t turretInput, uint8_t enemyInput);
+	void saveRollbackFrame(uint32_t tick);
+	void restoreRollbackFrame(uint32_t tick);
+	string botScenario;            // play with the bot, empty => human player
+	float botMinutes = 0;          // stop the bot run after this long, 0 => never
+	BotDriver bot;
+	ofxLabel memoryLabels[MEMORY_TAGS];
+	float nextMemoryLabel = 0;
+	MetricGauge *memoryGauges[MEMORY_TAGS];
+	MetricHistogram *allocHistogram;
+	int allocLimit = -1;           // allocations allowed per gameplay frame, -1 => no check
+	int allocFailures = 0;         // gameplay frames over allocLimit
+	int steadyFrames = 0;          // frames since gameplay (re)started
+	void checkAllocations();
 	
 
 